@@ -3,6 +3,7 @@
 get_property(FWK_ID_FILE_LIST GLOBAL PROPERTY FWK_ID_FILE_LIST)
 get_property(FWK_MSG_FILE_LIST GLOBAL PROPERTY FWK_MSG_FILE_LIST)
 get_property(FWK_TYPE_FILE_LIST GLOBAL PROPERTY FWK_TYPE_FILE_LIST)
+get_property(FWK_DISPATCH_FILE_LIST GLOBAL PROPERTY FWK_DISPATCH_FILE_LIST)
 
 # Include application-level includes (if set)
 if(DEFINED FWK_APP_ID_FILE_LIST)
@@ -14,6 +15,9 @@ endif()
 if(DEFINED FWK_APP_TYPE_FILE_LIST)
     list(APPEND FWK_TYPE_FILE_LIST ${FWK_APP_TYPE_FILE_LIST})
 endif()
+if(DEFINED FWK_APP_DISPATCH_FILE_LIST)
+    list(APPEND FWK_DISPATCH_FILE_LIST ${FWK_APP_DISPATCH_FILE_LIST})
+endif()
 
 if(NOT DEFINED FWK_ID_FILE_LIST)
     message(FATAL_ERROR "FWK_ID_FILE_LIST variable is not set, this must contain the input file list of framework IDs")
@@ -37,6 +41,9 @@ set(FWK_MSG_COUNT "1")
 set(FWK_TYPE_READ_LIST "")
 set(FWK_TYPE_VAR_LIST "")
 set(FWK_TYPE_COUNT "1")
+set(FWK_DISPATCH_READ_LIST "")
+set(FWK_DISPATCH_VAR_LIST "")
+set(FWK_DISPATCH_COUNT "1")
 
 set(FWK_ID_HEADER_FILE ${CMAKE_CURRENT_SOURCE_DIR}/template/template_ids_top.h)
 set(FWK_ID_FOOTER_FILE ${CMAKE_CURRENT_SOURCE_DIR}/template/template_ids_end.h)
@@ -55,13 +62,16 @@ set(FWK_MSG_FILE_FOOTER "\n/* END OF AUTOMATICALLY GENERATED FILE */")
 string(REPLACE ";" "\n * " FWK_TYPE_FILE_LIST_TEXTUAL "\n * ${FWK_TYPE_FILE_LIST}")
 set(FWK_TYPE_FILE_HEADER "/* AUTOMATICALLY GENERATED FILE - DO NOT EDIT BY HAND\n * Generated: ${CURRENT_TIME}\n * Input file list:${FWK_TYPE_FILE_LIST_TEXTUAL}\n */\n")
 set(FWK_TYPE_FILE_FOOTER "\n/* END OF AUTOMATICALLY GENERATED FILE */")
+string(REPLACE ";" "\n * " FWK_DISPATCH_FILE_LIST_TEXTUAL "\n * ${FWK_DISPATCH_FILE_LIST}")
+set(FWK_DISPATCH_FILE_HEADER "/* AUTOMATICALLY GENERATED FILE - DO NOT EDIT BY HAND\n * Generated: ${CURRENT_TIME}\n * Input file list:${FWK_DISPATCH_FILE_LIST_TEXTUAL}\n *\n * Included more than once (no include guard), see FrameworkDispatch.h\n */\n")
+set(FWK_DISPATCH_FILE_FOOTER "\n/* END OF AUTOMATICALLY GENERATED FILE */")
 set(GENERATED_PATH ${PROJECT_BINARY_DIR}/framework)
 
 # Create framework folder
 file(MAKE_DIRECTORY ${GENERATED_PATH})
 
 # Remove previous file if present
-file(REMOVE ${GENERATED_PATH}/framework_ids.h ${GENERATED_PATH}/framework_msgcodes.h ${GENERATED_PATH}/framework_types.h)
+file(REMOVE ${GENERATED_PATH}/framework_ids.h ${GENERATED_PATH}/framework_msgcodes.h ${GENERATED_PATH}/framework_types.h ${GENERATED_PATH}/framework_handlers.h)
 
 # IDs
 
@@ -180,10 +190,50 @@ add_custom_command(
     DEPENDS ${FWK_TYPE_FILE_LIST}
 )
 
+# Dispatch tables (handler lists)
+
+set(FWK_GENERATED_FILE_LIST ${GENERATED_PATH}/framework_ids.h ${GENERATED_PATH}/framework_msgcodes.h ${GENERATED_PATH}/framework_types.h)
+
+if(CONFIG_FWK_DISPATCH_TABLES)
+    # Add header
+    list(APPEND FWK_DISPATCH_READ_LIST "set(FWK_DISPATCH_FILE_HEADER \"${FWK_DISPATCH_FILE_HEADER}\")\n")
+    list(APPEND FWK_DISPATCH_VAR_LIST "\${FWK_DISPATCH_FILE_HEADER}")
+
+    # Parse all framework handler list input files
+    foreach (FWK_DISPATCH_FILE IN LISTS FWK_DISPATCH_FILE_LIST)
+        list(APPEND FWK_DISPATCH_READ_LIST "FILE(READ \"${FWK_DISPATCH_FILE}\" F${FWK_DISPATCH_COUNT}IN)\n")
+        list(APPEND FWK_DISPATCH_VAR_LIST "\${F${FWK_DISPATCH_COUNT}IN}")
+
+        # Increment framework handler list file count
+        math(EXPR FWK_DISPATCH_COUNT "${FWK_DISPATCH_COUNT}+1")
+    endforeach()
+
+    # Add footer
+    list(APPEND FWK_DISPATCH_READ_LIST "set(FWK_DISPATCH_FILE_FOOTER \"${FWK_DISPATCH_FILE_FOOTER}\")\n")
+    list(APPEND FWK_DISPATCH_VAR_LIST "\${FWK_DISPATCH_FILE_FOOTER}")
+
+    # Convert lists into strings
+    string(REPLACE ";" "" FWK_DISPATCH_READ_LIST "${FWK_DISPATCH_READ_LIST}")
+    string(REPLACE ";" "" FWK_DISPATCH_VAR_LIST "${FWK_DISPATCH_VAR_LIST}")
+
+    # Create the framework handler list cmake file
+    file(WRITE ${CMAKE_BINARY_DIR}/framework_handlers.cmake "${FWK_DISPATCH_READ_LIST}
+file(WRITE ${GENERATED_PATH}/framework_handlers.h \"${FWK_DISPATCH_VAR_LIST}\")\n")
+
+    # Add a custom command to generate the output merged framework handler list file
+    add_custom_command(
+        OUTPUT ${GENERATED_PATH}/framework_handlers.h
+        COMMAND ${CMAKE_COMMAND} -P ${CMAKE_BINARY_DIR}/framework_handlers.cmake
+        DEPENDS ${FWK_DISPATCH_FILE_LIST}
+    )
+
+    list(APPEND FWK_GENERATED_FILE_LIST ${GENERATED_PATH}/framework_handlers.h)
+endif()
+
 # Combined
 
 # Make zephyr depend on the framework ID/message code generation as a dependency
-add_custom_target(framework_gen DEPENDS ${GENERATED_PATH}/framework_ids.h ${GENERATED_PATH}/framework_msgcodes.h ${GENERATED_PATH}/framework_types.h)
+add_custom_target(framework_gen DEPENDS ${FWK_GENERATED_FILE_LIST})
 add_dependencies(zephyr framework_gen)
 
 # Add the framework ID folder to the list of includes
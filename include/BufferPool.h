@@ -19,6 +19,24 @@ extern "C" {
 #include <kernel.h>
 #include <stddef.h>
 
+#ifdef CONFIG_BUFFER_POOL_NAMED
+#include <init.h>
+#endif
+
+/******************************************************************************/
+/* Global Constants, Macros and Type Definitions                              */
+/******************************************************************************/
+/* Size of the header that precedes each buffer.  A buffer that isn't
+ * allocated from the pool (static) must reserve this many bytes before it.
+ */
+#define BUFFER_POOL_HEADER_SIZE                                                \
+	((IS_ENABLED(CONFIG_BUFFER_POOL_QUEUE_LINK) ? sizeof(void *) : 0) +    \
+	 (IS_ENABLED(CONFIG_BUFFER_POOL_CHECK_DOUBLE_FREE) ?                   \
+		  sizeof(void *) : 0) +                                        \
+	 (IS_ENABLED(CONFIG_BUFFER_POOL_TIMESTAMP) ? sizeof(uint32_t) : 0) +   \
+	 (IS_ENABLED(CONFIG_BUFFER_POOL_OWNER) ? sizeof(uint32_t) : 0) +       \
+	 sizeof(uint16_t) + (2 * sizeof(uint8_t)))
+
 /******************************************************************************/
 /* Global Function Prototypes                                                 */
 /******************************************************************************/
@@ -39,6 +57,45 @@ struct bp_stats {
 #endif
 };
 
+#ifdef CONFIG_BUFFER_POOL_NAMED
+/* A pool with its own heap (defined with BUFFER_POOL_DEFINE) */
+struct buffer_pool {
+	struct k_heap *heap;
+	const char *name;
+	size_t size;
+	uint8_t index; /* Assigned when the pool is registered */
+#ifdef CONFIG_BUFFER_POOL_STATS
+	struct bp_stats stats;
+#endif
+};
+
+/**
+ * @brief Statically define a buffer pool.  Buffers taken from it don't
+ * use the space of other pools.  The pool is registered during system
+ * initialization (POST_KERNEL).
+ */
+#define BUFFER_POOL_DEFINE(pool_name, pool_size)                               \
+	K_HEAP_DEFINE(_bp_heap_##pool_name, pool_size);                        \
+	struct buffer_pool pool_name = {                                       \
+		.heap = &_bp_heap_##pool_name,                                 \
+		.name = #pool_name,                                            \
+		.size = pool_size,                                             \
+	};                                                                     \
+	static int _bp_register_##pool_name(const struct device *device)       \
+	{                                                                      \
+		ARG_UNUSED(device);                                            \
+		return BufferPool_Register(&pool_name);                        \
+	}                                                                      \
+	SYS_INIT(_bp_register_##pool_name, POST_KERNEL, 0)
+
+#define BUFFER_POOL_DECLARE(name) extern struct buffer_pool name
+#endif
+
+#ifdef CONFIG_BUFFER_POOL_OWNER
+/* Called when the last owner frees a buffer that has an owner id */
+typedef void BufferPoolReleaseHandler_t(uint8_t owner, size_t size);
+#endif
+
 #define BP_CONTEXT_UNUSED "NA"
 
 #define BP_TRY_TO_TAKE(s) BufferPool_TryToTake(s, __func__)
@@ -83,20 +140,155 @@ void *BufferPool_TryToTake(size_t size, const char *const context);
  */
 void *BufferPool_Take(size_t size);
 
+/**
+ * @brief Same as BufferPool_TryToTakeTimeout, except only the header is
+ * initialized.  For callers that overwrite the whole buffer (a copy).
+ */
+void *BufferPool_TryToTakeTimeoutUninit(size_t size, k_timeout_t timeout,
+					const char *const context);
+
+/**
+ * @brief Same as BufferPool_TryToTake, except only the header is
+ * initialized.
+ */
+void *BufferPool_TryToTakeUninit(size_t size, const char *const context);
+
+/**
+ * @brief Same as BufferPool_Take, except only the header is initialized.
+ */
+void *BufferPool_TakeUninit(size_t size);
+
+#ifdef CONFIG_BUFFER_POOL_NAMED
+/**
+ * @brief Add a pool to the list of pools.  Called by BUFFER_POOL_DEFINE.
+ *
+ * @retval 0 on success, -ENOMEM if CONFIG_BUFFER_POOL_NAMED_MAX pools are
+ * already registered.
+ */
+int BufferPool_Register(struct buffer_pool *pool);
+
+/**
+ * @brief Same as BufferPool_TryToTakeTimeout, except the buffer is taken
+ * from a pool defined with BUFFER_POOL_DEFINE.
+ */
+void *BufferPool_TryToTakeFrom(struct buffer_pool *pool, size_t size,
+			       k_timeout_t timeout, const char *const context);
+
+/**
+ * @brief Same as BufferPool_Take, except the buffer is taken from a pool
+ * defined with BUFFER_POOL_DEFINE.
+ */
+void *BufferPool_TakeFrom(struct buffer_pool *pool, size_t size);
+#endif
+
 /**
  * @brief Put a buffer back into the free pool.
+ *
+ * @note The pool that the buffer was taken from is stored in its header.
+ *
+ * @note If the buffer has more than one owner, then this only releases
+ * the reference of the caller.
  */
 void BufferPool_Free(void *pBuffer);
 
+/**
+ * @brief Get the size that was requested when a buffer was taken.
+ */
+size_t BufferPool_GetSize(void *pBuffer);
+
+#ifdef CONFIG_BUFFER_POOL_QUEUE_LINK
+/**
+ * @brief Get the node (the first word is reserved for a k_fifo) of a buffer.
+ */
+void *BufferPool_GetNode(void *pBuffer);
+
+/**
+ * @brief Get a buffer from a node returned by BufferPool_GetNode.
+ */
+void *BufferPool_FromNode(void *pNode);
+#endif
+
+#ifdef CONFIG_BUFFER_POOL_TIMESTAMP
+/**
+ * @brief Store a timestamp in the header of a buffer.
+ */
+void BufferPool_SetTimestamp(void *pBuffer, uint32_t timestamp);
+
+/**
+ * @brief Get the timestamp stored in the header of a buffer.
+ */
+uint32_t BufferPool_GetTimestamp(void *pBuffer);
+#endif
+
+#ifdef CONFIG_BUFFER_POOL_OWNER
+/**
+ * @brief Store the id of the owner that is charged for a buffer.
+ * 0 means the buffer isn't charged.
+ */
+void BufferPool_SetOwner(void *pBuffer, uint8_t owner);
+
+/**
+ * @brief Get the id stored with BufferPool_SetOwner.
+ */
+uint8_t BufferPool_GetOwner(void *pBuffer);
+
+/**
+ * @brief Set the function that is called when a buffer that has an owner
+ * id is returned to the pool.
+ */
+void BufferPool_SetReleaseHandler(BufferPoolReleaseHandler_t *handler);
+#endif
+
+#ifdef CONFIG_BUFFER_POOL_REFERENCE_COUNT
+/**
+ * @brief Add owners to a buffer.  Each owner must call BufferPool_Free.
+ *
+ * @param pBuffer allocated from buffer pool
+ * @param count number of additional owners
+ */
+void BufferPool_AddReferences(void *pBuffer, size_t count);
+
+/**
+ * @brief Get a buffer that can be modified by the caller.
+ *
+ * If the caller is the only owner, then the buffer is returned.
+ * Otherwise, a copy is made and the reference of the caller to the shared
+ * buffer is released.  The original pointer must not be used after a copy
+ * is made.
+ *
+ * @note In a message handler, the returned buffer belongs to the handler.
+ * Return DISPATCH_DO_NOT_FREE after a copy is made.
+ *
+ * @retval NULL if a copy couldn't be allocated (caller is still an owner
+ * of the shared buffer).
+ */
+void *BufferPool_CopyOnWrite(void *pBuffer);
+
+/**
+ * @retval true if the buffer has more than one owner
+ */
+bool BufferPool_IsShared(void *pBuffer);
+#endif
+
 /**
  * @brief Get pointer to buffer pool statistics
  *
- * @param index of buffer pool.  Only 0 is valid at this time.
+ * @param index of buffer pool.  0 is the heap.  When
+ * CONFIG_BUFFER_POOL_SLABS is enabled, each slab follows (in order of
+ * increasing size).  Named pools follow the slabs.
  *
  * @return struct bp_stats* NULL if index isn't valid
  */
 struct bp_stats *BufferPool_GetStats(uint8_t index);
 
+/**
+ * @brief Get the name of a buffer pool ("heap", "slab" or the name given to
+ * BUFFER_POOL_DEFINE).
+ *
+ * @return NULL if index isn't valid
+ */
+const char *BufferPool_GetName(uint8_t index);
+
 #ifdef __cplusplus
 }
 #endif
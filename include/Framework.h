@@ -18,6 +18,8 @@ extern "C" {
 /******************************************************************************/
 #include <kernel.h>
 
+#include "BufferPool.h"
+
 /******************************************************************************/
 /* Readability                                                                */
 /******************************************************************************/
@@ -72,6 +74,17 @@ enum FwkMsgOptionBitmask {
 	FWK_MSG_OPTION_NONE = 0,
 	/* Callback option requires the callback message type to be used */
 	FWK_MSG_OPTION_CALLBACK = BIT(0),
+	/* Use the urgent queue of the receiver (if it has one) */
+	FWK_MSG_OPTION_URGENT = BIT(1),
+	/* Sent by the periodic timer of a task (periodic message type) */
+	FWK_MSG_OPTION_PERIODIC = BIT(2),
+	/* Not allocated from the buffer pool (the framework won't free it) */
+	FWK_MSG_OPTION_STATIC = BIT(3),
+	/* Sent by Framework_Call (requires the call message type) */
+	FWK_MSG_OPTION_CALL = BIT(4),
+	/* Header-only message that is sent by value (the framework won't free
+	 * it).  Only the msg code and ids are sent. */
+	FWK_MSG_OPTION_INLINE = BIT(5),
 };
 
 typedef enum DispatchResultEnum {
@@ -114,6 +127,40 @@ typedef struct FwkCallbackMsg {
 	uint32_t data;
 } FwkCallbackMsg_t;
 
+/* Framework call message
+ *
+ * Messages sent with Framework_Call must begin with this type.  The caller
+ * waits on a completion (on its stack) until the handler returns.
+ * The handler can write a response into the message.
+ */
+struct FwkCallCompletion;
+
+typedef struct FwkCallMsg {
+	FwkMsgHeader_t header;
+	atomic_ptr_t pCompletion; /* Set by Framework_Call */
+} FwkCallMsg_t;
+
+/* Handle of a message sent with Framework_SendDelayed.
+ * Contains a generation count so that a stale handle can't cancel a message
+ * that reused the same entry.
+ */
+typedef uint32_t FwkDelayHandle_t;
+
+/* Framework periodic message (FMC_PERIODIC)
+ *
+ * When periodic messages are coalesced, a task has at most one periodic
+ * message pending.  Missed is the number of timer expirations that occurred
+ * while the previous message was pending.  The message is released (and
+ * missed is set) when it is received.
+ */
+typedef struct FwkPeriodicMsg {
+	FwkMsgHeader_t header;
+	uint32_t missed;
+#ifdef CONFIG_FWK_COALESCE_PERIODIC
+	struct FwkMsgTask *pTask; /* Task that owns the timer */
+#endif
+} FwkPeriodicMsg_t;
+
 /*
  * Each message task has a message handler or dispatcher.
  * The dispatcher should be implemented using a case statement
@@ -123,18 +170,100 @@ typedef struct FwkCallbackMsg {
 typedef struct FwkMsgReceiver FwkMsgReceiver_t;
 typedef DispatchResult_t FwkMsgHandler_t(FwkMsgReceiver_t *pMsgRxer,
 					 FwkMsg_t *pMsg);
+#ifdef CONFIG_FWK_RECEIVER_QUOTAS
+/* What happens when a message would exceed the quota of a receiver */
+enum FwkQuotaPolicy {
+	/* The send fails (the caller frees the message) */
+	FWK_QUOTA_REJECT = 0,
+	/* The message is freed and the send succeeds */
+	FWK_QUOTA_DROP_NEWEST,
+	/* Queued messages charged to the receiver are freed (oldest first) to
+	 * make room.  The message is rejected when it is larger than the quota,
+	 * when the oldest message isn't charged to the receiver or for a single
+	 * producer, single consumer queue. */
+	FWK_QUOTA_DROP_OLDEST,
+};
+
+struct FwkQuotaUsage {
+	uint32_t bytes; /* Size of the buffers charged to the receiver */
+	uint32_t count; /* Number of buffers charged to the receiver */
+	uint32_t rejected;
+	uint32_t dropped;
+};
+#endif
+
 /*
  * Message Framework Receiver Object
  *
  * The dispatcher determines what function should handle each message.
  */
+#ifdef CONFIG_FWK_QUEUE_TYPES
+enum FwkQueueTypeEnum {
+	FWK_QUEUE_TYPE_MSGQ = 0,
+	FWK_QUEUE_TYPE_SPSC,
+	FWK_QUEUE_TYPE_FIFO,
+};
+
+#ifdef CONFIG_FWK_QUEUE_SPSC
+/* Lock-free ring for a single producer and a single consumer.
+ * The semaphores are only given when the other side is waiting.
+ */
+struct FwkSpscRing {
+	atomic_t head; /* Only written by producer */
+	atomic_t tail; /* Only written by consumer */
+	atomic_t waiting;
+	atomic_t spaceWaiting;
+	atomic_ptr_t producer; /* Thread of the first put (checked) */
+	uint32_t mask;
+	void **ppEntries;
+	struct k_sem available;
+	struct k_sem space;
+};
+#endif
+
+typedef struct FwkQueue {
+	uint8_t type;
+	union {
+		struct k_msgq msgq;
+#ifdef CONFIG_FWK_QUEUE_SPSC
+		struct FwkSpscRing spsc;
+#endif
+#ifdef CONFIG_FWK_QUEUE_FIFO
+		/* Messages are linked using their buffer pool header */
+		struct k_fifo fifo;
+#endif
+	};
+} FwkQueue_t;
+#else
 typedef struct k_msgq FwkQueue_t;
+#endif
 
 struct FwkMsgReceiver {
 	FwkId_t id;
 	FwkQueue_t *pQueue;
 	TickType_t rxBlockTicks;
 	FwkMsgHandler_t *(*pMsgDispatcher)(FwkMsgCode_t msgCode);
+#ifdef CONFIG_FWK_DISPATCH_TABLES
+	/* Optional handler for each msg code (used instead of the dispatcher).
+	 * Generated from a handler list (FrameworkDispatch.h). */
+	FwkMsgHandler_t *const *pDispatchTable;
+#endif
+	/* Maximum number of messages handled each time the receiver
+	 * wakes up (0 and 1 handle a single message). */
+	uint8_t maxBatch;
+#ifdef CONFIG_FWK_URGENT_QUEUE
+	/* Optional queue for messages with FWK_MSG_OPTION_URGENT.
+	 * It is always emptied before pQueue. */
+	FwkQueue_t *pUrgentQueue;
+#endif
+#ifdef CONFIG_FWK_RECEIVER_QUOTAS
+	/* Limits on the buffers that are queued to (or held by) the receiver.
+	 * A buffer is charged when it is queued and released when it is
+	 * freed.  0 is unlimited. */
+	uint32_t quotaBytes;
+	uint16_t quotaCount;
+	uint8_t quotaPolicy; /* enum FwkQuotaPolicy */
+#endif
 };
 
 /**
@@ -149,8 +278,53 @@ typedef struct FwkMsgTask {
 	struct k_timer timer;
 	TickType_t timerDurationTicks; /* Initial time */
 	TickType_t timerPeriodTicks; /* Second time (0 for one shot) */
+#ifdef CONFIG_FWK_CPU_AFFINITY
+	/* CPUs the thread can run on (bit n is CPU n).  0 for any CPU. */
+	uint32_t cpuMask;
+#endif
+#ifdef CONFIG_FWK_COALESCE_PERIODIC
+	atomic_t periodicPending;
+	atomic_t periodicMissed;
+#endif
+#ifdef CONFIG_FWK_STATIC_PERIODIC
+	/* Periodic message with room for a buffer pool header (never freed) */
+	struct {
+		uint8_t reserved[BUFFER_POOL_HEADER_SIZE];
+		FwkPeriodicMsg_t msg;
+	} __aligned(sizeof(void *)) periodic;
+#endif
 } FwkMsgTask_t;
 
+#ifdef CONFIG_FWK_LATENCY_STATS
+/**
+ * @brief Log2 histograms of the time (in cycles) that messages spent in the
+ * queue of a receiver and the time its handlers ran.
+ * Bucket n counts times less than 2^n (and at least 2^(n-1)) cycles.
+ * Only buffers that are queued to a receiver by the framework are
+ * timestamped.  Inline, static, shared broadcast and directly queued
+ * messages only add to the handler histogram.
+ */
+struct FwkLatencyStats {
+	uint32_t count;
+	uint32_t maxQueueCycles;
+	uint32_t maxHandlerCycles;
+	uint32_t queue[CONFIG_FWK_LATENCY_HISTOGRAM_BUCKETS];
+	uint32_t handler[CONFIG_FWK_LATENCY_HISTOGRAM_BUCKETS];
+};
+#endif
+
+#ifdef CONFIG_FWK_MSG_PROFILER
+/**
+ * @brief Handler time (in cycles) of a message code.
+ */
+struct FwkMsgProfile {
+	uint32_t count;
+	uint32_t minCycles;
+	uint32_t maxCycles;
+	uint64_t totalCycles;
+};
+#endif
+
 /**
  * @brief Get pointer to object containing task (in dispatcher context).
  *
@@ -163,6 +337,80 @@ typedef struct FwkMsgTask {
 #define FWK_TASK_CONTAINER(_obj_)                                              \
 	CONTAINER_OF(CONTAINER_OF(pMsgRxer, FwkMsgTask_t, rxer), _obj_, msgTask)
 
+#ifdef CONFIG_FWK_WORKER_POOL
+/**
+ * @brief Message Framework Worker Pool Object
+ *
+ * Several worker threads handle the messages sent to one receiver.
+ */
+typedef struct FwkMsgWorkerPool {
+	FwkMsgReceiver_t rxer;
+	/* Optional.  Returns true if the handler of a msg code can run in
+	 * more than one worker at a time.  Other handlers are serialized. */
+	bool (*pIsReentrant)(FwkMsgCode_t msgCode);
+	/* Messages from the same sender (txId) are handled in order */
+	bool orderByTxId;
+	struct k_mutex receive; /* One worker waits on the queue at a time */
+	struct k_mutex lock; /* Tickets */
+	struct k_mutex serial;
+	struct k_condvar done;
+	uint8_t nextTicket[CONFIG_FWK_MAX_MSG_RECEIVERS];
+	uint8_t servingTicket[CONFIG_FWK_MAX_MSG_RECEIVERS];
+} FwkMsgWorkerPool_t;
+
+/**
+ * @brief Message Framework Worker Object
+ *
+ * The receiver is a copy of the receiver of the pool.  It is passed to
+ * handlers so that each worker has its own context.
+ */
+typedef struct FwkMsgWorker {
+	FwkMsgReceiver_t rxer;
+	FwkMsgWorkerPool_t *pPool;
+} FwkMsgWorker_t;
+
+/**
+ * @brief Get pointer to object containing worker (in dispatcher context).
+ *
+ * Example:
+ * DispatchResult_t MsgHandler(FwkMsgReceiver_t *pMsgRxer, FwkMsg_t *pMsg)
+ * {
+ *   WorkerObj_t *pObj = FWK_WORKER_CONTAINER(WorkerObj_t);
+ * }
+ */
+#define FWK_WORKER_CONTAINER(_obj_)                                            \
+	CONTAINER_OF(CONTAINER_OF(pMsgRxer, FwkMsgWorker_t, rxer), _obj_,      \
+		     worker)
+#endif
+
+#ifdef CONFIG_FWK_MUX
+/**
+ * @brief Message Framework Multiplexer Object
+ *
+ * One thread services several receivers.  Receivers are listed in priority
+ * order (the first is the highest).
+ */
+typedef struct FwkMsgMux {
+	FwkMsgReceiver_t *const *ppReceivers;
+	size_t count;
+	/* Two for each receiver (queue and urgent queue) */
+	struct k_poll_event *pEvents;
+} FwkMsgMux_t;
+
+/**
+ * @brief Define a multiplexer for a list of receiver pointers.
+ */
+#define FWK_MUX_DEFINE(name, ...)                                              \
+	static FwkMsgReceiver_t *const _fwk_mux_rxers_##name[] = {             \
+		__VA_ARGS__                                                    \
+	};                                                                     \
+	static struct k_poll_event                                             \
+		_fwk_mux_events_##name[2 * ARRAY_SIZE(_fwk_mux_rxers_##name)]; \
+	FwkMsgMux_t name = { .ppReceivers = _fwk_mux_rxers_##name,             \
+			     .count = ARRAY_SIZE(_fwk_mux_rxers_##name),       \
+			     .pEvents = _fwk_mux_events_##name }
+#endif
+
 #define FWK_BUFFER_MSG_SIZE(t, s) (sizeof(t) + (s))
 
 /* Most framework messages are small.  This is a check that at least
@@ -177,6 +425,67 @@ typedef struct FwkMsgTask {
 #define FWK_QUEUE_ENTRY_SIZE (sizeof(FwkMsg_t *))
 #define FWK_QUEUE_ALIGNMENT 4 /* bytes */
 
+/**
+ * @brief Define a message queue (Zephyr message queue).
+ *
+ * @note When CONFIG_FWK_QUEUE_SPSC or CONFIG_FWK_QUEUE_FIFO is enabled,
+ * queues must be defined with these macros instead of K_MSGQ_DEFINE.
+ */
+#ifdef CONFIG_FWK_QUEUE_TYPES
+#define FWK_QUEUE_DEFINE(name, depth)                                          \
+	static char __aligned(FWK_QUEUE_ALIGNMENT)                             \
+		_fwk_queue_buf_##name[(depth) * FWK_QUEUE_ENTRY_SIZE];         \
+	FwkQueue_t name = {                                                    \
+		.type = FWK_QUEUE_TYPE_MSGQ,                                   \
+		.msgq = Z_MSGQ_INITIALIZER(name.msgq, _fwk_queue_buf_##name,   \
+					   FWK_QUEUE_ENTRY_SIZE, depth)        \
+	}
+
+#ifdef CONFIG_FWK_QUEUE_SPSC
+/**
+ * @brief Define a lock-free queue that can be used when a queue has a
+ * single producer (for example, an ISR) and a single consumer.
+ *
+ * @note Framework assertions check that every put is made from the thread
+ * (or interrupt context) of the first one.  The queue of a receiver must not
+ * be the target of broadcasts, periodic timer messages, delayed sends or
+ * sends to itself in addition to its producer, because each of those is
+ * another producer.
+ *
+ * @param depth must be a power of two
+ */
+#define FWK_SPSC_QUEUE_DEFINE(name, depth)                                     \
+	BUILD_ASSERT(((depth) & ((depth) - 1)) == 0,                           \
+		     "SPSC queue depth must be a power of two");               \
+	static void *_fwk_queue_buf_##name[depth];                             \
+	FwkQueue_t name = {                                                    \
+		.type = FWK_QUEUE_TYPE_SPSC,                                   \
+		.spsc = {                                                      \
+			.mask = (depth) - 1,                                   \
+			.ppEntries = _fwk_queue_buf_##name,                    \
+			.available = Z_SEM_INITIALIZER(name.spsc.available, 0, \
+						       K_SEM_MAX_LIMIT),       \
+			.space = Z_SEM_INITIALIZER(name.spsc.space, 0,         \
+						   K_SEM_MAX_LIMIT)            \
+		}                                                              \
+	}
+#endif
+
+#ifdef CONFIG_FWK_QUEUE_FIFO
+/**
+ * @brief Define a queue without a fixed depth.
+ * Messages are linked using a field in their buffer pool header, so only
+ * messages allocated from the buffer pool can be placed on the queue.
+ */
+#define FWK_FIFO_QUEUE_DEFINE(name)                                            \
+	FwkQueue_t name = { .type = FWK_QUEUE_TYPE_FIFO,                       \
+			    .fifo = Z_FIFO_INITIALIZER(name.fifo) }
+#endif
+#else
+#define FWK_QUEUE_DEFINE(name, depth)                                          \
+	K_MSGQ_DEFINE(name, FWK_QUEUE_ENTRY_SIZE, depth, FWK_QUEUE_ALIGNMENT)
+#endif
+
 /* Routing a message to task id 0 indicates a problem */
 #define FWK_ID_RESERVED 0
 #define FWK_ID_APP_START 1
@@ -198,27 +507,91 @@ typedef struct FwkMsgTask {
  * Messages can be routed based on their ID or based on whether or not
  * they have a function mapped to a message code in their dispatcher.
  *
+ * @note When CONFIG_FWK_ROUTING_INDEX is enabled the dispatcher is probed
+ * for every message code during registration.  The dispatcher must not
+ * change the set of message codes it handles after registration.
+ * The receiver is subscribed to broadcasts of every message code it handles.
+ *
  * @ref FwkTaskIds.h
  */
 void Framework_RegisterReceiver(FwkMsgReceiver_t *pRxer);
 void Framework_RegisterTask(FwkMsgTask_t *pMsgTask);
 
+#ifdef CONFIG_FWK_WORKER_POOL
+/**
+ * @brief Register the receiver of a worker pool.
+ */
+void Framework_RegisterWorkerPool(FwkMsgWorkerPool_t *pPool);
+
+/**
+ * @brief Add a worker to a registered pool.  Each worker must be serviced
+ * by its own thread (Framework_WorkerReceiver).
+ */
+void Framework_RegisterWorker(FwkMsgWorkerPool_t *pPool,
+			      FwkMsgWorker_t *pWorker);
+
+/**
+ * @brief Waits for rxBlockTicks (of the pool) for a message and then
+ * calls its handler in the context of the worker.
+ *
+ * @note Only one worker waits on the queue at a time.
+ *
+ * @retval Number of messages handled (0 or 1).
+ */
+size_t Framework_WorkerReceiver(FwkMsgWorker_t *pWorker);
+#endif
+
+#ifdef CONFIG_FWK_MUX
+/**
+ * @brief Waits up to BlockTicks for a message to arrive in the queue of
+ * any receiver of a multiplexer.  Then each receiver (in priority order)
+ * handles up to maxBatch messages, so a busy receiver can't starve the
+ * others.
+ *
+ * @note The receivers are registered as usual, but they must not be
+ * serviced by another thread.
+ *
+ * @retval Number of messages handled.
+ */
+size_t Framework_MuxReceiver(FwkMsgMux_t *pMux, TickType_t BlockTicks);
+#endif
+
 /**
  * @brief Wraps the queue receive function of the OS and waits for
  * rxBlockTicks for a message to arrive in a task's queue.
  * When a message is received the appropriate message handler
  * function is called by the dispatcher.
+ *
+ * If maxBatch is greater than one, then messages that are already
+ * in the queue are handled (up to maxBatch) without waiting again.
+ *
+ * @retval Number of messages handled.  A task loop can use this to
+ * yield after a burst of messages.
  */
-void Framework_MsgReceiver(FwkMsgReceiver_t *pMsgRxer);
+size_t Framework_MsgReceiver(FwkMsgReceiver_t *pMsgRxer);
 
 /**
  * @brief Sends a message to a single task based on a task ID.
  *
+ * @note If the message has the urgent option and the receiver has an
+ * urgent queue, then the message is placed on the urgent queue.
+ *
  * @retval An assert isn't generated if RxId is invalid.
  * @note Caller is responsible for freeing memory, if status isn't success.
  */
 BaseType_t Framework_Send(FwkId_t RxId, FwkMsg_t *pMsg);
 
+/**
+ * @brief Sends a message to a single task based on a task ID.
+ * If the queue of the task is full, then wait up to Timeout for room.
+ * Producers slow down instead of failing when a consumer falls behind.
+ *
+ * @note In interrupt context the timeout is ignored (K_NO_WAIT).
+ * @note Caller is responsible for freeing memory, if status isn't success.
+ */
+BaseType_t Framework_SendTimeout(FwkId_t RxId, FwkMsg_t *pMsg,
+				 TickType_t Timeout);
+
 /**
  * @brief Sends a single message to a single task by searching the
  * dispatcher of each message receiver.
@@ -227,44 +600,183 @@ BaseType_t Framework_Send(FwkId_t RxId, FwkMsg_t *pMsg);
  * @note This should not be used for messages that can go to more than
  * one destination.
  * @note As the number of tasks increases, the amount of time to find the
- * rxID increases.
+ * rxID increases (unless CONFIG_FWK_ROUTING_INDEX is enabled).
  *
  * @retval Caller is responsible for freeing memory, if status isn't success.
  */
 BaseType_t Framework_Unicast(FwkMsg_t *pMsg);
 
+/**
+ * @brief Sends a message and waits until its handler returns.
+ *
+ * @param pMsg must begin with FwkCallMsg_t.
+ * @param Timeout for sending the message and then for waiting for the
+ * handler (separately).
+ * @param pResult optional, the value returned by the handler or
+ * DISPATCH_ERROR if the receiver doesn't have a handler or flushed the
+ * message.
+ *
+ * @note Can't be used in interrupt context.  Handlers of call messages must
+ * not return DISPATCH_DO_NOT_FREE.
+ *
+ * @retval FWK_SUCCESS the handler returned and the message was given back
+ * to the caller (the caller must free it).
+ * -EAGAIN the handler didn't return in time.  The receiver frees the
+ * message.
+ * Otherwise, the message couldn't be sent and the caller must free it.
+ */
+BaseType_t Framework_Call(FwkId_t RxId, FwkMsg_t *pMsg, TickType_t Timeout,
+			  DispatchResult_t *pResult);
+
 /**
  * @brief Copies a message and sends it to all tasks that have the message
  * code in their dispatcher.
  *
  * @param MsgSize required to copy message.
  *
+ * @note When CONFIG_FWK_SHARED_BROADCAST is enabled the message isn't copied.
+ * Each receiver gets a reference to the same buffer.
+ *
  * @note Currently an assertion fires if this is called in interrupt context.
+ * Use Framework_BroadcastDeferred in interrupt context.
  *
  * @retval Caller is responsible for freeing memory, if status isn't success.
  */
 BaseType_t Framework_Broadcast(FwkMsg_t *pMsg, size_t MsgSize);
 
+#ifdef CONFIG_FWK_ROUTING_INDEX
+/**
+ * @brief Subscribe a receiver to broadcasts of a message code.
+ *
+ * @note Only affects broadcast routing.  Unicast routing still uses the
+ * dispatcher.
+ *
+ * @retval FWK_ERROR if the receiver isn't registered or its dispatcher
+ * doesn't have a handler for the message code.
+ */
+BaseType_t Framework_Subscribe(FwkId_t RxId, FwkMsgCode_t MsgCode);
+
+/**
+ * @brief Stop broadcasts of a message code from being sent to a receiver
+ * (for example, while it is in a low power mode).
+ *
+ * @retval FWK_ERROR if the receiver isn't registered.
+ */
+BaseType_t Framework_Unsubscribe(FwkId_t RxId, FwkMsgCode_t MsgCode);
+#endif
+
+#ifdef CONFIG_FWK_BROADCAST_DEFERRED
+/**
+ * @brief Puts a message on a ring that is emptied by the framework broadcast
+ * thread.  The thread calls Framework_Broadcast for each message.
+ * Takes constant time and can be used in interrupt context.
+ *
+ * @note The message must be allocated from the buffer pool because its size
+ * is taken from the buffer pool header.  The thread frees the message if it
+ * can't be broadcast.  Static and inline messages are rejected.
+ *
+ * @retval Caller is responsible for freeing memory, if status isn't success
+ * (the ring is full or the message isn't a buffer).
+ */
+BaseType_t Framework_BroadcastDeferred(FwkMsg_t *pMsg);
+#endif
+
+#ifdef CONFIG_FWK_DELAYED_SEND
+/**
+ * @brief Sends a message to a receiver after a delay.  The message is held
+ * in the framework timer wheel until it expires.
+ *
+ * @param Delay is rounded up to CONFIG_FWK_DELAYED_SEND_TICK_MS.
+ * The message isn't sent early.  An absolute timeout (K_TIMEOUT_ABS_MS) is
+ * converted to a delay.
+ * @param pHandle optional, can be used to cancel the message.
+ *
+ * @note Can be used in interrupt context.  If the message can't be sent when
+ * it expires, then it is freed.  Static and inline messages are rejected.
+ *
+ * @retval Caller is responsible for freeing memory, if status isn't success
+ * (no free entries in the wheel, the delay is too long or the message
+ * isn't a buffer).
+ */
+BaseType_t Framework_SendDelayed(FwkId_t RxId, FwkMsg_t *pMsg,
+				 TickType_t Delay, FwkDelayHandle_t *pHandle);
+
+/**
+ * @brief Cancels a delayed message and frees it.
+ *
+ * @retval FWK_ERROR if the message has already been sent (or cancelled).
+ */
+BaseType_t Framework_CancelDelayed(FwkDelayHandle_t Handle);
+#endif
+
 /**
  * @brief Bypasses message router and puts a message directly on a queue.
  *
  * @note Most commonly used by a task to send a message to itself.
+ *
+ * @note A message with FWK_MSG_OPTION_INLINE is packed into the queue entry.
+ * FIFO queues link buffers, so they get a copy from the buffer pool instead.
  */
 BaseType_t Framework_Queue(FwkQueue_t *pQueue, void *ppData,
 			   TickType_t BlockTicks);
 
 /**
- * @retval 0 if not not empty
+ * @retval 0 if not not empty (either queue of the receiver)
  */
 BaseType_t Framework_QueueIsEmpty(FwkId_t RxId);
 
 /**
- * @brief Free all messages in a receiver's queue.
+ * @brief Free all messages in a receiver's queue (and urgent queue).
  *
  * @retval Number of messages that were purged.
  */
 size_t Framework_Flush(FwkId_t RxId);
 
+/* Selects messages for Framework_FlushMatching and Framework_CountMatching.
+ * Called without the queue locked on a copy of the queue entries.  A message
+ * that is received while the queue is scanned may already be freed, so the
+ * scan should be done from the receiver's thread when the match reads more
+ * than the header.
+ */
+typedef bool FwkMsgMatch_t(const FwkMsg_t *pMsg, void *pContext);
+
+/**
+ * @brief Free the messages in a receiver's queue (and urgent queue) that
+ * match.  The order of the remaining messages is kept.
+ *
+ * @note Matching messages are removed in one step and freed after the queue
+ * is unlocked.  Messages that are received while the queue is scanned
+ * aren't purged.  For a single producer, single consumer queue this must be
+ * called from the receiver's thread.  A thread that is blocked sending to a
+ * full Zephyr message queue is given the space.
+ *
+ * @retval Number of messages that were purged (0 if a buffer for the copy
+ * of the queue entries can't be taken).
+ */
+size_t Framework_FlushMatching(FwkId_t RxId, FwkMsgMatch_t *pMatch,
+			       void *pContext);
+
+/**
+ * @brief Free the messages in a receiver's queues that have a message code.
+ */
+size_t Framework_FlushCode(FwkId_t RxId, FwkMsgCode_t MsgCode);
+
+/**
+ * @brief Count the messages in a receiver's queue (and urgent queue) that
+ * match.  The queue isn't changed.  The match function can also be used to
+ * peek at the messages.
+ *
+ * @note For a single producer, single consumer queue this must be called
+ * from the receiver's thread.
+ */
+size_t Framework_CountMatching(FwkId_t RxId, FwkMsgMatch_t *pMatch,
+			       void *pContext);
+
+/**
+ * @brief Count the messages in a receiver's queues that have a message code.
+ */
+size_t Framework_CountCode(FwkId_t RxId, FwkMsgCode_t MsgCode);
+
 /**
  * @brief Blocks on queue waiting for a message.
  *
@@ -277,9 +789,112 @@ size_t Framework_Flush(FwkId_t RxId);
  *
  * @note Only needed in special cases.
  * This function is called by Framework_MsgReceiver.
+ *
+ * @note When CONFIG_FWK_COALESCE_PERIODIC is enabled, receiving a periodic
+ * message allows the timer of its task to send the next one.
+ *
+ * @note When CONFIG_FWK_INLINE_MSGS is enabled, an inline message is copied
+ * into a buffer (that the caller frees).  When CONFIG_FWK_STATIC_PERIODIC is
+ * enabled, the periodic message of a task is also copied so that the timer
+ * can reuse it.  The receive fails if a buffer can't be taken.
  */
 BaseType_t Framework_Receive(FwkQueue_t *pQueue, void *ppData,
 			     TickType_t BlockTicks);
+
+#ifdef CONFIG_FWK_INLINE_MSGS
+/**
+ * @brief Framework_Receive without copying inline messages.  The entry must
+ * be unpacked with Framework_ExpandInline.
+ */
+BaseType_t Framework_ReceiveEntry(FwkQueue_t *pQueue, void *ppData,
+				  TickType_t BlockTicks);
+
+/**
+ * @brief Unpack an entry taken from a queue with Framework_ReceiveEntry.
+ *
+ * @param pStorage for the header of an inline message.
+ *
+ * @retval pStorage if the entry is an inline message, otherwise pEntry.
+ */
+FwkMsg_t *Framework_ExpandInline(FwkMsg_t *pEntry, FwkMsg_t *pStorage);
+#endif
+#ifdef CONFIG_FWK_LATENCY_STATS
+/**
+ * @brief Get the latency histograms of a receiver.
+ *
+ * @retval NULL if RxId isn't valid
+ */
+const struct FwkLatencyStats *Framework_GetLatencyStats(FwkId_t RxId);
+
+/**
+ * @brief Clear the latency histograms of a receiver.
+ */
+void Framework_ResetLatencyStats(FwkId_t RxId);
+#endif
+
+#ifdef CONFIG_FWK_CPU_AFFINITY
+/**
+ * @brief Apply the cpuMask of a task to its thread (pTid).
+ * Framework_RegisterTask does this if pTid is set.
+ *
+ * @note The thread must not be running (create it with a delay of
+ * K_FOREVER and start it afterwards).
+ *
+ * @retval FWK_ERROR if the thread is running or pTid isn't set
+ */
+BaseType_t Framework_ApplyCpuMask(FwkMsgTask_t *pMsgTask);
+#endif
+
+#ifdef CONFIG_FWK_RECEIVER_QUOTAS
+/**
+ * @brief Get the buffers charged to a receiver and the number of messages
+ * that were rejected or dropped because of its quota.
+ *
+ * @retval FWK_ERROR if the id isn't valid
+ */
+BaseType_t Framework_GetQuotaUsage(FwkId_t RxId, struct FwkQuotaUsage *pUsage);
+#endif
+
+#ifdef CONFIG_FWK_TRAFFIC_STATS
+/**
+ * @brief Get the number of messages sent by TxId that were handled by RxId.
+ */
+uint32_t Framework_GetTraffic(FwkId_t TxId, FwkId_t RxId);
+
+/**
+ * @brief Clear the traffic counters.
+ */
+void Framework_ResetTraffic(void);
+
+/**
+ * @brief Suggest a CPU for each receiver so that receivers that exchange
+ * the most messages share a CPU while the traffic is spread across CPUs.
+ * The heaviest pairs are placed first (greedy).
+ *
+ * @param pCpu array of CONFIG_FWK_MAX_MSG_RECEIVERS, receives the CPU
+ * of each receiver
+ * @param Cpus number of CPUs (limited to CONFIG_MP_NUM_CPUS)
+ *
+ * @retval FWK_ERROR if Cpus is 0
+ */
+BaseType_t Framework_SuggestPlacement(uint8_t *pCpu, uint32_t Cpus);
+#endif
+
+#ifdef CONFIG_FWK_MSG_PROFILER
+/**
+ * @brief Get a copy of the handler profile of a message code.
+ *
+ * @retval FWK_ERROR if MsgCode isn't valid
+ */
+BaseType_t Framework_GetMsgProfile(FwkMsgCode_t MsgCode,
+				   struct FwkMsgProfile *pProfile);
+
+/**
+ * @brief Clear the handler profile of all message codes.
+ */
+void Framework_ResetMsgProfile(void);
+#endif
+
 /**
  * @brief Starts a task's periodic timer
  */
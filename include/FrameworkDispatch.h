@@ -0,0 +1,54 @@
+/**
+ * @file FrameworkDispatch.h
+ * @brief Dispatch tables generated from handler lists.
+ *
+ * A handler list file contains one or more tables.
+ *
+ * FWK_DISPATCH_TABLE(sensorTask,
+ *	FWK_HANDLER(FMC_PERIODIC, SensorTaskPeriodicMsgHandler)
+ *	FWK_HANDLER(FMC_SOFTWARE_RESET, SensorTaskResetMsgHandler)
+ * )
+ *
+ * For each table, an array indexed by message code (sensorTaskDispatchTable)
+ * and a compatible dispatcher function (sensorTaskDispatcher) are generated.
+ * Handlers in a list must not be static.
+ *
+ * Copyright (c) 2022 Laird Connectivity
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef __FRAMEWORK_DISPATCH_H__
+#define __FRAMEWORK_DISPATCH_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************/
+/* Includes                                                                   */
+/******************************************************************************/
+#include "Framework.h"
+
+/******************************************************************************/
+/* Global Constants, Macros and Type Definitions                              */
+/******************************************************************************/
+/* Receiver initializer for the dispatcher and dispatch table of a list */
+#define FWK_DISPATCH(name)                                                     \
+	.pMsgDispatcher = name##Dispatcher, .pDispatchTable = name##DispatchTable
+
+/******************************************************************************/
+/* Global Data Definitions                                                    */
+/******************************************************************************/
+#define FWK_DISPATCH_TABLE(name, ...)                                          \
+	extern FwkMsgHandler_t *const name##DispatchTable[];                   \
+	FwkMsgHandler_t *name##Dispatcher(FwkMsgCode_t MsgCode);
+
+#include <framework_handlers.h>
+
+#undef FWK_DISPATCH_TABLE
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FRAMEWORK_DISPATCH_H__ */
@@ -30,6 +30,7 @@ extern "C" {
  * @param pMacroMsg - A previously created message that is ready to send.
  * @param cb - Callback function
  * @param data - Callback data
+ * @param timeout - Zephyr timeout
  */
 
 #define FRAMEWORK_MSG_SEND_TO_SELF(rxId, code)                                 \
@@ -37,9 +38,15 @@ extern "C" {
 
 #define FRAMEWORK_MSG_SEND(pMacroMsg) FwkMsg_Send((FwkMsg_t *)pMacroMsg)
 
+#define FRAMEWORK_MSG_SEND_URGENT(pMacroMsg)                                   \
+	FwkMsg_SendUrgent((FwkMsg_t *)pMacroMsg)
+
 #define FRAMEWORK_MSG_TRY_TO_SEND(pMacroMsg)                                   \
 	FwkMsg_TryToSend((FwkMsg_t *)pMacroMsg)
 
+#define FRAMEWORK_MSG_SEND_TIMEOUT(pMacroMsg, timeout)                         \
+	FwkMsg_SendTimeout((FwkMsg_t *)pMacroMsg, timeout)
+
 #define FRAMEWORK_MSG_SEND_TO(destId, pMacroMsg)                               \
 	FwkMsg_SendTo((FwkMsg_t *)pMacroMsg, destId)
 
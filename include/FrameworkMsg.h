@@ -49,6 +49,16 @@ extern "C" {
  */
 BaseType_t FwkMsg_Send(FwkMsg_t *pMsg);
 
+/**
+ * @brief Wrapper for Framework_Send that sets the urgent option.
+ * The message is placed on the urgent queue of the receiver (if it has one).
+ *
+ * @param pMsg pointer to a framework message
+ *
+ * @retval FWK_SUCCESS or FWK_ERROR
+ */
+BaseType_t FwkMsg_SendUrgent(FwkMsg_t *pMsg);
+
 /**
  * @brief Wrapper for Framework_Send that doesn't assert if dest queue is full.
  *
@@ -58,6 +68,18 @@ BaseType_t FwkMsg_Send(FwkMsg_t *pMsg);
  */
 BaseType_t FwkMsg_TryToSend(FwkMsg_t *pMsg);
 
+/**
+ * @brief Wrapper for Framework_SendTimeout.
+ * Waits up to Timeout for room in the destination queue.
+ * It doesn't assert if the message can't be sent.
+ *
+ * @param pMsg pointer to a framework message
+ * @param Timeout zephyr timeout (ignored in interrupt context)
+ *
+ * @retval FWK_SUCCESS or FWK_ERROR
+ */
+BaseType_t FwkMsg_SendTimeout(FwkMsg_t *pMsg, TickType_t Timeout);
+
 /**
  * @brief Wrapper for Framework_Send when used with FRAMEWORK_MSG_HEADER_INIT.
  *
@@ -127,6 +149,8 @@ BaseType_t FwkMsg_CreateAndBroadcast(FwkId_t TxId, FwkMsgCode_t Code);
  *
  * @note Often used with DISPATCH_DO_NOT_FREE.
  * @note The original sender must populate the txId.
+ * @note A shared broadcast (CONFIG_FWK_SHARED_BROADCAST) is copied before
+ * its header is changed.
  *
  * @param pMsg pointer to a framework message
  * @param Code message type
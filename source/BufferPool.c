@@ -23,59 +23,413 @@ LOG_MODULE_REGISTER(buffer_pool, LOG_LEVEL_WRN);
 /* Local Constant, Macro and Type Definitions                                 */
 /******************************************************************************/
 struct bph {
+#ifdef CONFIG_BUFFER_POOL_QUEUE_LINK
+	void *link; /* Must be first (reserved for k_fifo) */
+#endif
 #ifdef CONFIG_BUFFER_POOL_CHECK_DOUBLE_FREE
 	void *ptr;
+#endif
+#ifdef CONFIG_BUFFER_POOL_TIMESTAMP
+	uint32_t timestamp;
+#endif
+#ifdef CONFIG_BUFFER_POOL_OWNER
+	uint8_t owner; /* Id charged for the buffer (0 if none) */
+	uint8_t reserved[3];
 #endif
 	uint16_t size;
 	uint8_t pool;
-	uint8_t reserved;
+	uint8_t refs; /* Number of owners in addition to the first */
 } __packed;
 
 #define BPH_SIZE sizeof(struct bph)
+BUILD_ASSERT(BPH_SIZE == BUFFER_POOL_HEADER_SIZE, "Unexpected Header Size");
+
+#define BPH(p) ((struct bph *)(((uint8_t *)(p)) - BPH_SIZE))
+
+/* Pool 0 is the heap.  Slab n is pool n.  Named pools follow the slabs
+ * (in the order they are registered).
+ */
+#define HEAP_POOL 0
+
+#ifdef CONFIG_BUFFER_POOL_SLABS
+/* Memory used by a slab buffer of the largest size (header included) */
+#define SLAB_BLOCK_SIZE(size) ROUND_UP((size) + BPH_SIZE, sizeof(void *))
+
+#define SLAB_DEFINE(n)                                                         \
+	K_MEM_SLAB_DEFINE(buffer_pool_slab_##n,                                \
+			  SLAB_BLOCK_SIZE(CONFIG_BUFFER_POOL_SLAB_##n##_SIZE), \
+			  CONFIG_BUFFER_POOL_SLAB_##n##_COUNT, sizeof(void *))
+
+#define SLAB_CLASS(n)                                                          \
+	{                                                                      \
+		.slab = &buffer_pool_slab_##n,                                 \
+		.size = CONFIG_BUFFER_POOL_SLAB_##n##_SIZE,                    \
+		.count = CONFIG_BUFFER_POOL_SLAB_##n##_COUNT,                  \
+	}
+
+struct slab_class {
+	struct k_mem_slab *slab;
+	uint16_t size; /* Largest buffer */
+	uint16_t count;
+};
+#endif
 
 /******************************************************************************/
 /* Local Data Definitions                                                     */
 /******************************************************************************/
 static K_HEAP_DEFINE(buffer_pool, CONFIG_BUFFER_POOL_SIZE);
 
+#ifdef CONFIG_BUFFER_POOL_SLABS
+SLAB_DEFINE(1);
+#if CONFIG_BUFFER_POOL_SLAB_CLASSES > 1
+SLAB_DEFINE(2);
+#endif
+#if CONFIG_BUFFER_POOL_SLAB_CLASSES > 2
+SLAB_DEFINE(3);
+#endif
+#if CONFIG_BUFFER_POOL_SLAB_CLASSES > 3
+SLAB_DEFINE(4);
+#endif
+
+/* In order of increasing size */
+static const struct slab_class slab_classes[] = {
+	SLAB_CLASS(1),
+#if CONFIG_BUFFER_POOL_SLAB_CLASSES > 1
+	SLAB_CLASS(2),
+#endif
+#if CONFIG_BUFFER_POOL_SLAB_CLASSES > 2
+	SLAB_CLASS(3),
+#endif
+#if CONFIG_BUFFER_POOL_SLAB_CLASSES > 3
+	SLAB_CLASS(4),
+#endif
+};
+
+#define BUILT_IN_POOLS (1 + ARRAY_SIZE(slab_classes))
+#define IS_SLAB(pool) ((pool) != HEAP_POOL && (pool) < BUILT_IN_POOLS)
+#else
+#define BUILT_IN_POOLS 1
+#define IS_SLAB(pool) false
+#endif
+
+#ifdef CONFIG_BUFFER_POOL_NAMED
+BUILD_ASSERT(BUILT_IN_POOLS + CONFIG_BUFFER_POOL_NAMED_MAX <= UINT8_MAX,
+	     "Pool index is stored in a byte");
+
+static struct buffer_pool *named_pools[CONFIG_BUFFER_POOL_NAMED_MAX];
+static atomic_t named_count;
+#endif
+
 static atomic_t take_failed = ATOMIC_INIT(0);
 
 #ifdef CONFIG_BUFFER_POOL_STATS
-static struct bp_stats bps;
+static struct bp_stats bps[BUILT_IN_POOLS];
+#endif
+
+#ifdef CONFIG_BUFFER_POOL_REFERENCE_COUNT
+static struct k_spinlock ref_lock;
+#endif
+
+#ifdef CONFIG_BUFFER_POOL_OWNER
+static BufferPoolReleaseHandler_t *release_handler;
 #endif
 
 /******************************************************************************/
 /* Local Function Prototypes                                                  */
 /******************************************************************************/
+static void *TakeFromPool(uint8_t pool, size_t size, k_timeout_t timeout,
+			  const char *const context, bool zero);
+static void *CheckTake(void *ptr);
+static struct k_heap *HeapOf(uint8_t pool);
+
+#ifdef CONFIG_BUFFER_POOL_SLABS
+static uint8_t *SlabAlloc(size_t size, uint8_t *pool);
+#endif
+
+#ifdef CONFIG_BUFFER_POOL_NAMED
+static struct buffer_pool *NamedPool(uint8_t pool);
+#endif
+
 #ifdef CONFIG_BUFFER_POOL_STATS
+static void InitStats(struct bp_stats *stats, int space);
+static struct bp_stats *StatsOf(uint8_t pool);
+static int SpaceUsed(struct bph *bph);
 static void TakeStatHandler(struct bph *bph, size_t size);
-static void TakeFailStatHandler(size_t size);
+static void TakeFailStatHandler(uint8_t pool, size_t size);
 static void GiveStatHandler(struct bph *bph);
 #endif
 
+#ifdef CONFIG_BUFFER_POOL_REFERENCE_COUNT
+static bool ReleaseReference(struct bph *bph);
+#endif
+
 /******************************************************************************/
 /* Global Function Definitions                                                */
 /******************************************************************************/
 void BufferPool_Initialize(void)
 {
 #ifdef CONFIG_BUFFER_POOL_STATS
-	if (!bps.initialized) {
-		bps.initialized = true;
-		bps.space_available = CONFIG_BUFFER_POOL_SIZE;
-		bps.min_space_available = CONFIG_BUFFER_POOL_SIZE;
-		bps.min_size = CONFIG_BUFFER_POOL_SIZE;
+	InitStats(&bps[HEAP_POOL], CONFIG_BUFFER_POOL_SIZE);
+#ifdef CONFIG_BUFFER_POOL_SLABS
+	size_t i;
+	for (i = 0; i < ARRAY_SIZE(slab_classes); i++) {
+		InitStats(&bps[i + 1], SLAB_BLOCK_SIZE(slab_classes[i].size) *
+					       slab_classes[i].count);
 	}
 #endif
+#endif
 }
 
 void *BufferPool_TryToTakeTimeout(size_t size, k_timeout_t timeout,
 				  const char *const context)
+{
+	return TakeFromPool(HEAP_POOL, size, timeout, context, true);
+}
+
+void *BufferPool_TryToTake(size_t size, const char *const context)
+{
+	return BufferPool_TryToTakeTimeout(size, K_NO_WAIT, context);
+}
+
+void *BufferPool_Take(size_t size)
+{
+	return CheckTake(BufferPool_TryToTake(size, BP_CONTEXT_UNUSED));
+}
+
+void *BufferPool_TryToTakeTimeoutUninit(size_t size, k_timeout_t timeout,
+					const char *const context)
+{
+	return TakeFromPool(HEAP_POOL, size, timeout, context, false);
+}
+
+void *BufferPool_TryToTakeUninit(size_t size, const char *const context)
+{
+	return BufferPool_TryToTakeTimeoutUninit(size, K_NO_WAIT, context);
+}
+
+void *BufferPool_TakeUninit(size_t size)
+{
+	return CheckTake(BufferPool_TryToTakeUninit(size, BP_CONTEXT_UNUSED));
+}
+
+#ifdef CONFIG_BUFFER_POOL_NAMED
+int BufferPool_Register(struct buffer_pool *pool)
+{
+	atomic_val_t i = atomic_inc(&named_count);
+
+	if (i >= CONFIG_BUFFER_POOL_NAMED_MAX) {
+		LOG_ERR("Too many buffer pools (%s)", pool->name);
+		FRAMEWORK_ASSERT(FORCED);
+		return -ENOMEM;
+	}
+
+#ifdef CONFIG_BUFFER_POOL_STATS
+	InitStats(&pool->stats, pool->size);
+#endif
+	named_pools[i] = pool;
+	pool->index = BUILT_IN_POOLS + i;
+	return 0;
+}
+
+void *BufferPool_TryToTakeFrom(struct buffer_pool *pool, size_t size,
+			       k_timeout_t timeout, const char *const context)
+{
+	if (pool == NULL || pool->index == HEAP_POOL) {
+		/* Not registered */
+		FRAMEWORK_ASSERT(FORCED);
+		return NULL;
+	}
+	return TakeFromPool(pool->index, size, timeout, context, true);
+}
+
+void *BufferPool_TakeFrom(struct buffer_pool *pool, size_t size)
+{
+	return CheckTake(BufferPool_TryToTakeFrom(pool, size, K_NO_WAIT,
+						  BP_CONTEXT_UNUSED));
+}
+#endif
+
+void BufferPool_Free(void *pBuffer)
+{
+	uint8_t *p = pBuffer;
+	p -= BPH_SIZE;
+
+#ifdef CONFIG_BUFFER_POOL_REFERENCE_COUNT
+	if (ReleaseReference((struct bph *)p)) {
+		return;
+	}
+#endif
+
+#ifdef CONFIG_BUFFER_POOL_OWNER
+	if (((struct bph *)p)->owner != 0 && release_handler != NULL) {
+		release_handler(((struct bph *)p)->owner,
+				((struct bph *)p)->size);
+	}
+#endif
+
+#ifdef CONFIG_BUFFER_POOL_STATS
+	GiveStatHandler((struct bph *)p);
+#endif
+
+#ifdef CONFIG_BUFFER_POOL_SLABS
+	uint8_t pool = ((struct bph *)p)->pool;
+	if (IS_SLAB(pool)) {
+		k_mem_slab_free(slab_classes[pool - 1].slab, (void **)&p);
+		return;
+	}
+#endif
+
+	k_heap_free(HeapOf(((struct bph *)p)->pool), p);
+}
+
+size_t BufferPool_GetSize(void *pBuffer)
+{
+	return BPH(pBuffer)->size;
+}
+
+#ifdef CONFIG_BUFFER_POOL_QUEUE_LINK
+void *BufferPool_GetNode(void *pBuffer)
+{
+	return BPH(pBuffer);
+}
+
+void *BufferPool_FromNode(void *pNode)
+{
+	return ((uint8_t *)pNode) + BPH_SIZE;
+}
+#endif
+
+#ifdef CONFIG_BUFFER_POOL_TIMESTAMP
+void BufferPool_SetTimestamp(void *pBuffer, uint32_t timestamp)
+{
+	BPH(pBuffer)->timestamp = timestamp;
+}
+
+uint32_t BufferPool_GetTimestamp(void *pBuffer)
+{
+	return BPH(pBuffer)->timestamp;
+}
+#endif
+
+#ifdef CONFIG_BUFFER_POOL_OWNER
+void BufferPool_SetOwner(void *pBuffer, uint8_t owner)
+{
+	BPH(pBuffer)->owner = owner;
+}
+
+uint8_t BufferPool_GetOwner(void *pBuffer)
+{
+	return BPH(pBuffer)->owner;
+}
+
+void BufferPool_SetReleaseHandler(BufferPoolReleaseHandler_t *handler)
+{
+	release_handler = handler;
+}
+#endif
+
+#ifdef CONFIG_BUFFER_POOL_REFERENCE_COUNT
+void BufferPool_AddReferences(void *pBuffer, size_t count)
+{
+	struct bph *bph = BPH(pBuffer);
+	k_spinlock_key_t key = k_spin_lock(&ref_lock);
+
+	FRAMEWORK_ASSERT((bph->refs + count) <= UINT8_MAX);
+	bph->refs += count;
+
+	k_spin_unlock(&ref_lock, key);
+}
+
+void *BufferPool_CopyOnWrite(void *pBuffer)
+{
+	struct bph *bph = BPH(pBuffer);
+	void *pCopy;
+
+	/* References are only added by an owner.
+	 * If there is only one owner, then it must be the caller. */
+	if (bph->refs == 0) {
+		return pBuffer;
+	}
+
+	/* The copy is taken from the heap of the original (a slab buffer
+	 * is copied from the default heap or a slab). */
+	pCopy = TakeFromPool(IS_SLAB(bph->pool) ? HEAP_POOL : bph->pool,
+			     bph->size, K_NO_WAIT, __func__, false);
+	if (pCopy != NULL) {
+		memcpy(pCopy, pBuffer, bph->size);
+		BufferPool_Free(pBuffer);
+	}
+
+	return pCopy;
+}
+
+bool BufferPool_IsShared(void *pBuffer)
+{
+	return (BPH(pBuffer)->refs > 0);
+}
+#endif
+
+struct bp_stats *BufferPool_GetStats(uint8_t index)
+{
+	struct bp_stats *p = NULL;
+
+#ifdef CONFIG_BUFFER_POOL_STATS
+	if (index < BUILT_IN_POOLS) {
+		p = &bps[index];
+	}
+#ifdef CONFIG_BUFFER_POOL_NAMED
+	if (NamedPool(index) != NULL) {
+		p = &NamedPool(index)->stats;
+	}
+#endif
+#endif
+
+	return p;
+}
+
+const char *BufferPool_GetName(uint8_t index)
+{
+	if (index == HEAP_POOL) {
+		return "heap";
+	}
+	if (IS_SLAB(index)) {
+		return "slab";
+	}
+#ifdef CONFIG_BUFFER_POOL_NAMED
+	if (NamedPool(index) != NULL) {
+		return NamedPool(index)->name;
+	}
+#endif
+	return NULL;
+}
+
+/******************************************************************************/
+/* Local Function Definitions                                                 */
+/******************************************************************************/
+/**
+ * @param pool the heap or a named pool.  Slabs are tried first when the
+ * heap is selected.
+ * @param zero clear the buffer (the header is always cleared)
+ */
+static void *TakeFromPool(uint8_t pool, size_t size, k_timeout_t timeout,
+			  const char *const context, bool zero)
 {
 	size_t size_with_header = size + BPH_SIZE;
-	uint8_t *p = k_heap_alloc(&buffer_pool, size_with_header, timeout);
+	uint8_t *p = NULL;
+
+#ifdef CONFIG_BUFFER_POOL_SLABS
+	if (pool == HEAP_POOL) {
+		p = SlabAlloc(size, &pool);
+	}
+#endif
+	if (p == NULL) {
+		p = k_heap_alloc(HeapOf(pool), size_with_header, timeout);
+	}
 
 	if (p != NULL) {
-		memset(p, 0, size_with_header);
+		memset(p, 0, zero ? size_with_header : BPH_SIZE);
+		((struct bph *)p)->size = size;
+		((struct bph *)p)->pool = pool;
 #ifdef CONFIG_BUFFER_POOL_STATS
 		TakeStatHandler((struct bph *)p, size);
 #endif
@@ -83,21 +437,14 @@ void *BufferPool_TryToTakeTimeout(size_t size, k_timeout_t timeout,
 	} else {
 		LOG_WRN("Allocate failure size: %d context: %s", size, context);
 #ifdef CONFIG_BUFFER_POOL_STATS
-		TakeFailStatHandler(size);
+		TakeFailStatHandler(pool, size);
 #endif
 		return p;
 	}
 }
 
-void *BufferPool_TryToTake(size_t size, const char *const context)
+static void *CheckTake(void *ptr)
 {
-	return BufferPool_TryToTakeTimeout(size, K_NO_WAIT, context);
-}
-
-void *BufferPool_Take(size_t size)
-{
-	void *ptr = BufferPool_TryToTake(size, BP_CONTEXT_UNUSED);
-
 	if (ptr == NULL) {
 		/* Prevent recursive entry. */
 		if (atomic_get(&take_failed) == 0) {
@@ -109,62 +456,124 @@ void *BufferPool_Take(size_t size)
 	return ptr;
 }
 
-void BufferPool_Free(void *pBuffer)
+static struct k_heap *HeapOf(uint8_t pool)
 {
-	uint8_t *p = pBuffer;
-	p -= BPH_SIZE;
-
-#ifdef CONFIG_BUFFER_POOL_STATS
-	GiveStatHandler((struct bph *)p);
+#ifdef CONFIG_BUFFER_POOL_NAMED
+	if (pool >= BUILT_IN_POOLS) {
+		return NamedPool(pool)->heap;
+	}
 #endif
+	return &buffer_pool;
+}
 
-	k_heap_free(&buffer_pool, p);
+#ifdef CONFIG_BUFFER_POOL_NAMED
+/**
+ * @retval NULL if the index isn't a registered pool
+ */
+static struct buffer_pool *NamedPool(uint8_t pool)
+{
+	atomic_val_t count =
+		MIN(atomic_get(&named_count), CONFIG_BUFFER_POOL_NAMED_MAX);
+
+	if (pool < BUILT_IN_POOLS || (pool - BUILT_IN_POOLS) >= count) {
+		return NULL;
+	}
+	return named_pools[pool - BUILT_IN_POOLS];
 }
+#endif
 
-struct bp_stats *BufferPool_GetStats(uint8_t index)
+#ifdef CONFIG_BUFFER_POOL_SLABS
+/**
+ * @brief Take a block from the smallest slab that fits and isn't empty.
+ *
+ * @retval NULL if the heap must be used
+ */
+static uint8_t *SlabAlloc(size_t size, uint8_t *pool)
 {
-	struct bp_stats *p = NULL;
+	void *p;
+	size_t i;
+
+	for (i = 0; i < ARRAY_SIZE(slab_classes); i++) {
+		const struct slab_class *c = &slab_classes[i];
+
+		if (size <= c->size &&
+		    k_mem_slab_alloc(c->slab, &p, K_NO_WAIT) == 0) {
+			*pool = i + 1;
+			return p;
+		}
+	}
+
+	return NULL;
+}
+#endif
 
 #ifdef CONFIG_BUFFER_POOL_STATS
-	if (index == 0) {
-		p = &bps;
+static void InitStats(struct bp_stats *stats, int space)
+{
+	if (!stats->initialized) {
+		stats->initialized = true;
+		stats->space_available = space;
+		stats->min_space_available = space;
+		stats->min_size = space;
+	}
+}
+
+static struct bp_stats *StatsOf(uint8_t pool)
+{
+#ifdef CONFIG_BUFFER_POOL_NAMED
+	if (pool >= BUILT_IN_POOLS) {
+		return &NamedPool(pool)->stats;
 	}
 #endif
+	return &bps[pool];
+}
 
-	return p;
+/**
+ * @brief A slab buffer uses a whole block (header and padding included).
+ */
+static int SpaceUsed(struct bph *bph)
+{
+#ifdef CONFIG_BUFFER_POOL_SLABS
+	if (IS_SLAB(bph->pool)) {
+		return SLAB_BLOCK_SIZE(slab_classes[bph->pool - 1].size);
+	}
+#endif
+	return bph->size;
 }
 
-/******************************************************************************/
-/* Local Function Definitions                                                 */
-/******************************************************************************/
-#ifdef CONFIG_BUFFER_POOL_STATS
 static void TakeStatHandler(struct bph *bph, size_t size)
 {
-	bph->size = size;
+	struct bp_stats *stats = StatsOf(bph->pool);
+
 #ifdef CONFIG_BUFFER_POOL_CHECK_DOUBLE_FREE
 	bph->ptr = bph;
 #endif
 
-	bps.space_available -= size;
-	bps.min_space_available =
-		MIN(bps.min_space_available, bps.space_available);
-	bps.min_size = MIN(bps.min_size, size);
-	bps.max_size = MAX(bps.max_size, size);
-	bps.allocs += 1;
-	bps.cur_allocs += 1;
-	bps.max_allocs = MAX(bps.max_allocs, bps.cur_allocs);
+	stats->space_available -= SpaceUsed(bph);
+	stats->min_space_available =
+		MIN(stats->min_space_available, stats->space_available);
+	stats->min_size = MIN(stats->min_size, size);
+	stats->max_size = MAX(stats->max_size, size);
+	stats->allocs += 1;
+	stats->cur_allocs += 1;
+	stats->max_allocs = MAX(stats->max_allocs, stats->cur_allocs);
 #if CONFIG_BUFFER_POOL_WINDOW_SIZE > 0
-	bps.window[bps.windex++] = size;
-	if (bps.windex >= CONFIG_BUFFER_POOL_WINDOW_SIZE) {
-		bps.windex = 0;
+	stats->window[stats->windex++] = size;
+	if (stats->windex >= CONFIG_BUFFER_POOL_WINDOW_SIZE) {
+		stats->windex = 0;
 	}
 #endif
 }
 
-static void TakeFailStatHandler(size_t size)
+/**
+ * @note Slabs don't fail (they fall back to the heap).
+ */
+static void TakeFailStatHandler(uint8_t pool, size_t size)
 {
-	bps.take_failures += 1;
-	bps.last_fail_size = size;
+	struct bp_stats *stats = StatsOf(pool);
+
+	stats->take_failures += 1;
+	stats->last_fail_size = size;
 }
 
 static void GiveStatHandler(struct bph *bph)
@@ -184,7 +593,29 @@ static void GiveStatHandler(struct bph *bph)
 	}
 #endif
 
-	bps.space_available += bph->size;
-	bps.cur_allocs -= 1;
+	struct bp_stats *stats = StatsOf(bph->pool);
+
+	stats->space_available += SpaceUsed(bph);
+	stats->cur_allocs -= 1;
+}
+#endif
+
+#ifdef CONFIG_BUFFER_POOL_REFERENCE_COUNT
+/**
+ * @retval true if the buffer still has an owner
+ */
+static bool ReleaseReference(struct bph *bph)
+{
+	bool shared;
+	k_spinlock_key_t key = k_spin_lock(&ref_lock);
+
+	shared = (bph->refs > 0);
+	if (shared) {
+		bph->refs -= 1;
+	}
+
+	k_spin_unlock(&ref_lock, key);
+
+	return shared;
 }
 #endif
@@ -37,12 +37,17 @@ static int bp_stats(const struct shell *shell, size_t argc, char **argv)
 {
 	ARG_UNUSED(argc);
 	ARG_UNUSED(argv);
-	const uint8_t POOL_INDEX = 0;
+	uint8_t index = 0;
 
-	struct bp_stats *stats = BufferPool_GetStats(POOL_INDEX);
+	struct bp_stats *stats = BufferPool_GetStats(index);
 
-	if (stats != NULL) {
-		shell_print(shell, "Buffer Pool %u", POOL_INDEX);
+	if (stats == NULL) {
+		shell_error(shell, "Buffer pool not found");
+	}
+
+	while (stats != NULL) {
+		shell_print(shell, "Buffer Pool %u (%s)", index,
+			    BufferPool_GetName(index));
 		shell_print(shell, "stats initialized     %u",
 			    stats->initialized);
 		shell_print(shell, "space available       %d",
@@ -70,8 +75,8 @@ static int bp_stats(const struct shell *shell, size_t argc, char **argv)
 		}
 		shell_fprintf(shell, SHELL_NORMAL, "%u\n", stats->window[i]);
 #endif
-	} else {
-		shell_error(shell, "Buffer pool not found");
+		index += 1;
+		stats = BufferPool_GetStats(index);
 	}
 	return 0;
 }
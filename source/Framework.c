@@ -17,6 +17,8 @@
 /******************************************************************************/
 #include <init.h>
 #include <string.h>
+#include <ksched.h>
+#include <wait_q.h>
 
 #include "BufferPool.h"
 #include "Framework.h"
@@ -29,6 +31,67 @@
 /******************************************************************************/
 /* Local Constant, Macro and Type Definitions                                 */
 /******************************************************************************/
+#if defined(CONFIG_FWK_LATENCY_STATS) || defined(CONFIG_FWK_MSG_PROFILER)
+#define TIME_HANDLERS
+#endif
+
+#if defined(CONFIG_FWK_URGENT_QUEUE) || defined(CONFIG_FWK_MUX)
+#define POLL_QUEUES
+#endif
+
+#ifdef CONFIG_FWK_LATENCY_STATS
+/* A timestamp of 0 means that the buffer wasn't stamped when it was queued */
+#define LATENCY_STAMP() (k_cycle_get_32() | 1)
+#endif
+
+#ifdef CONFIG_FWK_BROADCAST_DEFERRED
+#define DEFERRED_SLOT(i)                                                       \
+	(&deferredRing[(i) & (CONFIG_FWK_BROADCAST_DEFERRED_DEPTH - 1)])
+#endif
+
+#ifdef CONFIG_FWK_STATIC_PERIODIC
+#define PERIODIC_MSG_OPTIONS (FWK_MSG_OPTION_PERIODIC | FWK_MSG_OPTION_STATIC)
+#define IS_STATIC_PERIODIC(m)                                                  \
+	((m)->header.msgCode == FMC_PERIODIC &&                                \
+	 ((m)->header.options & FWK_MSG_OPTION_STATIC))
+#else
+#define PERIODIC_MSG_OPTIONS FWK_MSG_OPTION_PERIODIC
+#endif
+
+#ifdef CONFIG_FWK_SHARED_BROADCAST
+/* Static and inline messages don't have a buffer header */
+#define IS_SHARED(m)                                                           \
+	(!((m)->header.options &                                               \
+	   (FWK_MSG_OPTION_STATIC | FWK_MSG_OPTION_INLINE)) &&                 \
+	 BufferPool_IsShared(m))
+#endif
+
+#ifdef CONFIG_FWK_QUEUE_SPSC
+/* Producer of a ring that is filled in interrupt context */
+#define SPSC_ISR_PRODUCER ((void *)1)
+#endif
+
+#ifdef CONFIG_FWK_INLINE_MSGS
+/* An inline message is a tagged queue entry.  Buffers are aligned, so bit 0
+ * of a message pointer is never set.
+ * [31:24] rxId, [23:16] txId, [15:8] msgCode, [7:1] options, [0] tag
+ */
+#define INLINE_TAG BIT(0)
+#define INLINE_OPTIONS_MASK 0x7F
+#define IS_INLINE_ENTRY(p) (((uintptr_t)(p)&INLINE_TAG) != 0)
+#define INLINE_ENTRY(h)                                                        \
+	((FwkMsg_t *)(((uintptr_t)(h).rxId << 24) |                            \
+		      ((uintptr_t)(h).txId << 16) |                            \
+		      ((uintptr_t)(h).msgCode << 8) |                          \
+		      (((uintptr_t)(h).options & INLINE_OPTIONS_MASK) << 1) |  \
+		      INLINE_TAG))
+#endif
+
+struct FwkCallCompletion {
+	struct k_sem done;
+	DispatchResult_t result;
+};
+
 typedef struct MsgTaskArrayEntry {
 	FwkMsgReceiver_t *pMsgReceiver;
 	bool inUse;
@@ -41,13 +104,200 @@ static int Framework_Initialize(const struct device *device);
 
 static void PeriodicTimerCallbackIsr(struct k_timer *pArg);
 
+static int QueuePut(FwkQueue_t *pQueue, void *ppData, TickType_t BlockTicks);
+static int QueueGet(FwkQueue_t *pQueue, void *ppData, TickType_t BlockTicks);
+static bool QueueIsEmpty(FwkQueue_t *pQueue);
+
+static BaseType_t QueueTo(FwkMsgReceiver_t *pMsgRxer, FwkMsg_t *pMsg,
+			  TickType_t Timeout);
+
+#ifdef CONFIG_FWK_RECEIVER_QUOTAS
+static BaseType_t QueueCharged(FwkMsgReceiver_t *pMsgRxer, FwkQueue_t *pQueue,
+			       FwkMsg_t *pMsg, TickType_t Timeout);
+static bool QuotaCharge(FwkMsgReceiver_t *pMsgRxer, size_t Size);
+static void QuotaRelease(uint8_t Owner, size_t Size);
+static bool DropOldest(FwkQueue_t *pQueue, uint8_t Owner);
+static bool DropOldestMsgq(struct k_msgq *pMsgq, uint8_t Owner);
+#ifdef CONFIG_FWK_QUEUE_FIFO
+static bool DropOldestFifo(struct k_fifo *pFifo, uint8_t Owner);
+#endif
+static bool IsCharged(FwkMsg_t *pEntry, uint8_t Owner);
+#endif
+
+#ifdef CONFIG_FWK_INLINE_MSGS
+static BaseType_t QueueInline(FwkQueue_t *pQueue, FwkMsg_t *pMsg,
+			      TickType_t BlockTicks);
+#endif
+
+#ifdef POLL_QUEUES
+static void QueuePollEventInit(struct k_poll_event *pEvent,
+			       FwkQueue_t *pQueue);
+#endif
+
+#ifdef CONFIG_FWK_QUEUE_SPSC
+static int SpscPut(struct FwkSpscRing *pRing, void *ppData,
+		   TickType_t BlockTicks);
+static int SpscGet(struct FwkSpscRing *pRing, void *ppData,
+		   TickType_t BlockTicks);
+#endif
+
+static FwkQueue_t *SelectQueue(FwkMsgReceiver_t *pMsgRxer, FwkMsg_t *pMsg);
+
+static BaseType_t ReceiveEntry(FwkQueue_t *pQueue, void *ppData,
+			       TickType_t BlockTicks);
+static BaseType_t ReceiveFromLanes(FwkMsgReceiver_t *pRxer, FwkMsg_t **ppMsg,
+				   TickType_t BlockTicks);
+
+static size_t FlushQueue(FwkQueue_t *pQueue);
+
+static size_t ScanReceiver(FwkId_t RxId, FwkMsgMatch_t *pMatch,
+			   void *pContext, bool Discard);
+static size_t ScanQueue(FwkQueue_t *pQueue, FwkMsgMatch_t *pMatch,
+			void *pContext, bool Discard);
+static size_t ScanMsgq(struct k_msgq *pMsgq, FwkMsgMatch_t *pMatch,
+		       void *pContext, bool Discard);
+static void MsgqRemoveHead(struct k_msgq *pMsgq, size_t Count,
+			   k_spinlock_key_t Key);
+#ifdef CONFIG_FWK_QUEUE_SPSC
+static size_t ScanSpsc(struct FwkSpscRing *pRing, FwkMsgMatch_t *pMatch,
+		       void *pContext, bool Discard);
+#endif
+#ifdef CONFIG_FWK_QUEUE_FIFO
+static size_t ScanFifo(struct k_fifo *pFifo, FwkMsgMatch_t *pMatch,
+		       void *pContext, bool Discard);
+#endif
+static bool MatchCode(const FwkMsg_t *pMsg, void *pContext);
+
+static void FreeMsg(FwkMsg_t *pMsg);
+
+static void DiscardMsg(FwkMsg_t *pMsg);
+
+static bool CompleteCall(FwkMsg_t *pMsg, DispatchResult_t Result);
+
+static void PrepareToDispatch(FwkMsg_t *pMsg);
+
+#ifdef CONFIG_FWK_MUX
+static size_t MuxServiceReady(FwkMsgMux_t *pMux);
+#endif
+
+static FwkMsgHandler_t *FindHandler(FwkMsgReceiver_t *pRxer,
+				    FwkMsgCode_t MsgCode);
+
+static void Dispatch(FwkMsgReceiver_t *pRxer, FwkMsg_t *pMsg);
+
+static size_t FindBroadcastReceivers(FwkMsgCode_t MsgCode,
+				     FwkMsgReceiver_t **ppReceivers);
+
+#ifdef CONFIG_FWK_LATENCY_STATS
+static void RecordLatency(FwkId_t RxId, bool Timestamped, uint32_t QueueCycles,
+			  uint32_t HandlerCycles);
+#endif
+
+#ifdef CONFIG_FWK_MSG_PROFILER
+static void RecordMsgProfile(FwkMsgCode_t MsgCode, uint32_t HandlerCycles);
+#endif
+
+#ifdef CONFIG_FWK_TRAFFIC_STATS
+static void RecordTraffic(FwkId_t TxId, FwkId_t RxId);
+static uint32_t LeastLoadedCpu(const uint32_t *pLoad, uint32_t Cpus);
+#endif
+
+#if !defined(CONFIG_FWK_SHARED_BROADCAST) || defined(CONFIG_FWK_QUEUE_FIFO) || \
+	defined(CONFIG_FWK_RECEIVER_QUOTAS)
+static BaseType_t BroadcastCopyTo(FwkMsgReceiver_t *pMsgRxer, FwkMsg_t *pMsg,
+				  size_t MsgSize);
+#endif
+
+static BaseType_t BroadcastTo(FwkMsgReceiver_t *pMsgRxer, FwkMsg_t *pMsg,
+			      size_t MsgSize);
+
+#ifdef CONFIG_FWK_ROUTING_INDEX
+static void IndexReceiver(FwkMsgReceiver_t *pRxer);
+static FwkMsgReceiver_t *SubscriptionReceiver(FwkId_t RxId,
+					      FwkMsgCode_t MsgCode);
+#endif
+
+#ifdef CONFIG_FWK_COALESCE_PERIODIC
+static void ReleasePeriodic(FwkMsg_t *pMsg);
+#endif
+
+#ifdef CONFIG_FWK_BROADCAST_DEFERRED
+static void BroadcastThread(void *pArg1, void *pArg2, void *pArg3);
+#endif
+
+/******************************************************************************/
+/* Local Data Definitions                                                     */
+/******************************************************************************/
 static MsgTaskArrayEntry_t msgTaskRegistry[CONFIG_FWK_MAX_MSG_RECEIVERS];
 
+#ifdef CONFIG_FWK_ROUTING_INDEX
+/* The lowest receiver id that has a handler for each msg code */
+static FwkId_t unicastIndex[NUMBER_OF_FRAMEWORK_MSG_CODES];
+
+/* Bit n is set when receiver n is subscribed to the msg code */
+static atomic_t broadcastIndex[NUMBER_OF_FRAMEWORK_MSG_CODES];
+
+BUILD_ASSERT(CONFIG_FWK_MAX_MSG_RECEIVERS <= 32,
+	     "Broadcast index requires one bit per receiver");
+#endif
+
+#ifdef CONFIG_FWK_LATENCY_STATS
+static struct FwkLatencyStats latencyStats[CONFIG_FWK_MAX_MSG_RECEIVERS];
+/* The workers of a pool share statistics */
+static struct k_spinlock latencyLock[CONFIG_FWK_MAX_MSG_RECEIVERS];
+#endif
+
+#ifdef CONFIG_FWK_MSG_PROFILER
+static struct FwkMsgProfile msgProfile[NUMBER_OF_FRAMEWORK_MSG_CODES];
+static struct k_spinlock msgProfileLock;
+#endif
+
+#ifdef CONFIG_FWK_TRAFFIC_STATS
+/* Messages handled by each receiver [rxId] from each sender [txId] */
+static atomic_t traffic[CONFIG_FWK_MAX_MSG_RECEIVERS]
+		      [CONFIG_FWK_MAX_MSG_RECEIVERS];
+#endif
+
+#ifdef CONFIG_FWK_RECEIVER_QUOTAS
+BUILD_ASSERT(CONFIG_FWK_MAX_MSG_RECEIVERS < UINT8_MAX,
+	     "Buffer owner is the receiver id + 1");
+
+#define QUOTA_OWNER(id) ((uint8_t)((id) + 1))
+
+/* Buffers charged to each receiver [rxId] */
+static struct {
+	atomic_t bytes;
+	atomic_t count;
+	atomic_t rejected;
+	atomic_t dropped;
+} quotaUsage[CONFIG_FWK_MAX_MSG_RECEIVERS];
+#endif
+
+#ifdef CONFIG_FWK_BROADCAST_DEFERRED
+BUILD_ASSERT((CONFIG_FWK_BROADCAST_DEFERRED_DEPTH &
+	      (CONFIG_FWK_BROADCAST_DEFERRED_DEPTH - 1)) == 0,
+	     "Deferred broadcast depth must be a power of two");
+
+/* Multiple producers reserve a slot (head) and then fill it.
+ * The broadcast thread empties filled slots in order (tail).
+ */
+static atomic_t deferredHead;
+static atomic_t deferredTail;
+static atomic_ptr_t deferredRing[CONFIG_FWK_BROADCAST_DEFERRED_DEPTH];
+static K_SEM_DEFINE(deferredAvailable, 0, K_SEM_MAX_LIMIT);
+#endif
+
 /******************************************************************************/
 /* Global Function Definitions                                                */
 /******************************************************************************/
 SYS_INIT(Framework_Initialize, POST_KERNEL, 0);
 
+#ifdef CONFIG_FWK_BROADCAST_DEFERRED
+K_THREAD_DEFINE(fwk_broadcast, CONFIG_FWK_BROADCAST_DEFERRED_STACK_SIZE,
+		BroadcastThread, NULL, NULL, NULL,
+		CONFIG_FWK_BROADCAST_DEFERRED_PRIORITY, 0, 0);
+#endif
+
 void Framework_RegisterReceiver(FwkMsgReceiver_t *pRxer)
 {
 	FRAMEWORK_ASSERT(pRxer != NULL);
@@ -63,6 +313,9 @@ void Framework_RegisterReceiver(FwkMsgReceiver_t *pRxer)
 		if (!msgTaskRegistry[pRxer->id].inUse) {
 			msgTaskRegistry[pRxer->id].inUse = true;
 			msgTaskRegistry[pRxer->id].pMsgReceiver = pRxer;
+#ifdef CONFIG_FWK_ROUTING_INDEX
+			IndexReceiver(pRxer);
+#endif
 		} else {
 			FRAMEWORK_ASSERT(FORCED);
 		}
@@ -75,9 +328,51 @@ void Framework_RegisterTask(FwkMsgTask_t *pMsgTask)
 	FRAMEWORK_ASSERT(pMsgTask != NULL);
 	Framework_RegisterReceiver(&pMsgTask->rxer);
 	k_timer_init(&pMsgTask->timer, PeriodicTimerCallbackIsr, NULL);
+#ifdef CONFIG_FWK_COALESCE_PERIODIC
+	atomic_clear(&pMsgTask->periodicPending);
+	atomic_clear(&pMsgTask->periodicMissed);
+#endif
+#ifdef CONFIG_FWK_CPU_AFFINITY
+	if (pMsgTask->pTid != NULL) {
+		Framework_ApplyCpuMask(pMsgTask);
+	}
+#endif
+}
+
+#ifdef CONFIG_FWK_CPU_AFFINITY
+BaseType_t Framework_ApplyCpuMask(FwkMsgTask_t *pMsgTask)
+{
+	FRAMEWORK_ASSERT(pMsgTask != NULL);
+	if (pMsgTask->pTid == NULL) {
+		return FWK_ERROR;
+	}
+
+	int status;
+	uint32_t cpu;
+
+	if (pMsgTask->cpuMask == 0) {
+		status = k_thread_cpu_mask_enable_all(pMsgTask->pTid);
+	} else {
+		status = k_thread_cpu_mask_clear(pMsgTask->pTid);
+		for (cpu = 0; cpu < CONFIG_MP_NUM_CPUS; cpu++) {
+			if (status == 0 && (pMsgTask->cpuMask & BIT(cpu))) {
+				status = k_thread_cpu_mask_enable(
+					pMsgTask->pTid, cpu);
+			}
+		}
+	}
+
+	return (status == 0) ? FWK_SUCCESS : FWK_ERROR;
 }
+#endif
 
 BaseType_t Framework_Send(FwkId_t RxId, FwkMsg_t *pMsg)
+{
+	return Framework_SendTimeout(RxId, pMsg, K_NO_WAIT);
+}
+
+BaseType_t Framework_SendTimeout(FwkId_t RxId, FwkMsg_t *pMsg,
+				 TickType_t Timeout)
 {
 	FRAMEWORK_ASSERT(pMsg != NULL);
 	BaseType_t result = FWK_ERROR;
@@ -91,10 +386,16 @@ BaseType_t Framework_Send(FwkId_t RxId, FwkMsg_t *pMsg)
 		return result;
 	}
 
+#ifdef CONFIG_FWK_SHARED_BROADCAST
+	/* A handler must use BufferPool_CopyOnWrite before it forwards a
+	 * shared broadcast (the header is changed). */
+	FRAMEWORK_ASSERT(!IS_SHARED(pMsg));
+#endif
+
 	FwkMsgReceiver_t *pMsgRxer = msgTaskRegistry[RxId].pMsgReceiver;
 	if (pMsgRxer != NULL) {
 		pMsg->header.rxId = RxId;
-		result = Framework_Queue(pMsgRxer->pQueue, &pMsg, K_NO_WAIT);
+		result = QueueTo(pMsgRxer, pMsg, Timeout);
 	}
 	return result;
 }
@@ -106,26 +407,39 @@ BaseType_t Framework_Unicast(FwkMsg_t *pMsg)
 	if (pMsg == NULL) {
 		return result;
 	}
+#ifdef CONFIG_FWK_SHARED_BROADCAST
+	FRAMEWORK_ASSERT(!IS_SHARED(pMsg));
+#endif
 
+#ifdef CONFIG_FWK_ROUTING_INDEX
+	if (pMsg->header.msgCode < NUMBER_OF_FRAMEWORK_MSG_CODES) {
+		FwkId_t id = unicastIndex[pMsg->header.msgCode];
+		if (id != FWK_ID_RESERVED) {
+			pMsg->header.rxId = id;
+			result = QueueTo(msgTaskRegistry[id].pMsgReceiver,
+					 pMsg, K_NO_WAIT);
+		}
+	}
+#else
 	uint32_t i;
 	for (i = FWK_ID_APP_START; i < CONFIG_FWK_MAX_MSG_RECEIVERS; i++) {
 		FwkMsgReceiver_t *pMsgRxer = msgTaskRegistry[i].pMsgReceiver;
 
-		if (pMsgRxer != NULL && pMsgRxer->pMsgDispatcher != NULL) {
+		if (pMsgRxer != NULL) {
 			/* The handler isn't called here.
 			 * It is only used to find the task the message belongs to. */
 			FwkMsgHandler_t *msgHandler =
-				pMsgRxer->pMsgDispatcher(pMsg->header.msgCode);
+				FindHandler(pMsgRxer, pMsg->header.msgCode);
 
 			/* If there is a dispatcher, then send the message to that task. */
 			if (msgHandler != NULL) {
 				pMsg->header.rxId = pMsgRxer->id;
-				result = Framework_Queue(pMsgRxer->pQueue,
-							 &pMsg, K_NO_WAIT);
+				result = QueueTo(pMsgRxer, pMsg, K_NO_WAIT);
 				break;
 			}
 		}
 	}
+#endif
 
 	return result;
 }
@@ -143,34 +457,35 @@ int Framework_Broadcast(FwkMsg_t *pMsg, size_t MsgSize)
 	FRAMEWORK_ASSERT(!Framework_InterruptContext());
 #endif
 
-	uint32_t i;
-	for (i = FWK_ID_APP_START; i < CONFIG_FWK_MAX_MSG_RECEIVERS; i++) {
-		FwkMsgReceiver_t *pMsgRxer = msgTaskRegistry[i].pMsgReceiver;
-
-		if (pMsgRxer != NULL && pMsgRxer->pMsgDispatcher != NULL) {
-			/* The handler isn't called here.  It is only used to determine
-			 * if a task should receive a broadcast message. */
-			FwkMsgHandler_t *msgHandler =
-				pMsgRxer->pMsgDispatcher(pMsg->header.msgCode);
+	FwkMsgReceiver_t *receivers[CONFIG_FWK_MAX_MSG_RECEIVERS];
+	size_t count = FindBroadcastReceivers(pMsg->header.msgCode, receivers);
+	size_t i;
 
-			/* If there is a dispatcher,
-			 * then create a copy of the message and place on the queue. */
-			if (msgHandler != NULL) {
-				FwkMsg_t *pNewMsg =
-					(FwkMsg_t *)BufferPool_Take(MsgSize);
-				if (pNewMsg != NULL) {
-					memcpy(pNewMsg, pMsg, MsgSize);
-					pNewMsg->header.rxId = pMsgRxer->id;
-					result = Framework_Queue(
-						pMsgRxer->pQueue, &pNewMsg,
-						K_NO_WAIT);
-
-					if (result != FWK_SUCCESS) {
-						BufferPool_Free(pNewMsg);
-					}
-				}
-			}
+#ifdef CONFIG_FWK_INLINE_MSGS
+	/* Each receiver gets the header by value (nothing to copy or free). */
+	if (pMsg->header.options & FWK_MSG_OPTION_INLINE) {
+		for (i = 0; i < count; i++) {
+			FwkMsgReceiver_t *pMsgRxer = receivers[i];
+			pMsg->header.rxId = pMsgRxer->id;
+			result = Framework_Queue(SelectQueue(pMsgRxer, pMsg),
+						 &pMsg, K_NO_WAIT);
 		}
+		return result;
+	}
+#endif
+
+#ifdef CONFIG_FWK_SHARED_BROADCAST
+#ifdef CONFIG_FWK_LATENCY_STATS
+	/* A shared buffer has one timestamp, so it isn't stamped */
+	BufferPool_SetTimestamp(pMsg, 0);
+#endif
+	/* Each receiver must be an owner before the message is queued because
+	 * a receiver can free the message before this loop completes. */
+	BufferPool_AddReferences(pMsg, count);
+#endif
+
+	for (i = 0; i < count; i++) {
+		result = BroadcastTo(receivers[i], pMsg, MsgSize);
 	}
 
 	/* Free Original Message Memory only when all messages were routed.
@@ -184,6 +499,110 @@ int Framework_Broadcast(FwkMsg_t *pMsg, size_t MsgSize)
 	return result;
 }
 
+#ifdef CONFIG_FWK_ROUTING_INDEX
+BaseType_t Framework_Subscribe(FwkId_t RxId, FwkMsgCode_t MsgCode)
+{
+	FwkMsgReceiver_t *pMsgRxer = SubscriptionReceiver(RxId, MsgCode);
+	if (pMsgRxer == NULL || FindHandler(pMsgRxer, MsgCode) == NULL) {
+		return FWK_ERROR;
+	}
+
+	atomic_set_bit(&broadcastIndex[MsgCode], RxId);
+	return FWK_SUCCESS;
+}
+
+BaseType_t Framework_Unsubscribe(FwkId_t RxId, FwkMsgCode_t MsgCode)
+{
+	if (SubscriptionReceiver(RxId, MsgCode) == NULL) {
+		return FWK_ERROR;
+	}
+
+	atomic_clear_bit(&broadcastIndex[MsgCode], RxId);
+	return FWK_SUCCESS;
+}
+#endif
+
+#ifdef CONFIG_FWK_BROADCAST_DEFERRED
+BaseType_t Framework_BroadcastDeferred(FwkMsg_t *pMsg)
+{
+	FRAMEWORK_ASSERT(pMsg != NULL);
+	if (pMsg == NULL) {
+		return FWK_ERROR;
+	}
+
+	/* The size of the message (and the thread that frees it) requires a
+	 * buffer pool header. */
+	if (pMsg->header.options &
+	    (FWK_MSG_OPTION_STATIC | FWK_MSG_OPTION_INLINE)) {
+		FRAMEWORK_ASSERT(false);
+		return FWK_ERROR;
+	}
+
+	atomic_val_t head;
+	do {
+		head = atomic_get(&deferredHead);
+		if ((uint32_t)(head - atomic_get(&deferredTail)) >=
+		    CONFIG_FWK_BROADCAST_DEFERRED_DEPTH) {
+			return FWK_ERROR;
+		}
+	} while (!atomic_cas(&deferredHead, head, head + 1));
+
+	atomic_ptr_set(DEFERRED_SLOT(head), pMsg);
+	k_sem_give(&deferredAvailable);
+
+	return FWK_SUCCESS;
+}
+#endif
+
+BaseType_t Framework_Call(FwkId_t RxId, FwkMsg_t *pMsg, TickType_t Timeout,
+			  DispatchResult_t *pResult)
+{
+	FRAMEWORK_ASSERT(pMsg != NULL);
+	FRAMEWORK_ASSERT(!Framework_InterruptContext());
+	if (pMsg == NULL) {
+		return FWK_ERROR;
+	}
+
+#ifdef CONFIG_FWK_INLINE_MSGS
+	/* An inline message is only a header (it has no completion) */
+	if (pMsg->header.options & FWK_MSG_OPTION_INLINE) {
+		FRAMEWORK_ASSERT(false);
+		return FWK_ERROR;
+	}
+#endif
+
+	FwkCallMsg_t *pCallMsg = (FwkCallMsg_t *)pMsg;
+	struct FwkCallCompletion completion;
+	BaseType_t status;
+
+	k_sem_init(&completion.done, 0, 1);
+	completion.result = DISPATCH_ERROR;
+	pMsg->header.options |= FWK_MSG_OPTION_CALL;
+	atomic_ptr_set(&pCallMsg->pCompletion, &completion);
+
+	status = Framework_SendTimeout(RxId, pMsg, Timeout);
+	if (status != FWK_SUCCESS) {
+		return status;
+	}
+
+	if (k_sem_take(&completion.done, Timeout) != 0) {
+		/* Whoever clears the completion first decides who frees the
+		 * message.  If the receiver doesn't find the completion, then
+		 * it frees the message. */
+		if (atomic_ptr_cas(&pCallMsg->pCompletion, &completion,
+				   NULL)) {
+			return -EAGAIN;
+		}
+		/* The handler has returned and the semaphore is being given. */
+		k_sem_take(&completion.done, K_FOREVER);
+	}
+
+	if (pResult != NULL) {
+		*pResult = completion.result;
+	}
+	return FWK_SUCCESS;
+}
+
 BaseType_t Framework_Queue(FwkQueue_t *pQueue, void *ppData,
 			   TickType_t BlockTicks)
 {
@@ -204,28 +623,147 @@ BaseType_t Framework_Queue(FwkQueue_t *pQueue, void *ppData,
 		return FWK_ERROR;
 	}
 
+#ifdef CONFIG_FWK_STATIC_PERIODIC
+	/* The periodic message of a task is released when it is freed.
+	 * It can't be forwarded because the timer reuses it. */
+	FRAMEWORK_ASSERT(!(IS_STATIC_PERIODIC(pMsg) &&
+			   !(pMsg->header.options & FWK_MSG_OPTION_PERIODIC)));
+#endif
+
+#ifdef CONFIG_FWK_INLINE_MSGS
+	if (pMsg->header.options & FWK_MSG_OPTION_INLINE) {
+		/* The completion of a call isn't part of the header */
+		if (pMsg->header.options & FWK_MSG_OPTION_CALL) {
+			FRAMEWORK_ASSERT(false);
+			return FWK_ERROR;
+		}
+		return QueueInline(pQueue, pMsg, BlockTicks);
+	}
+#endif
+
 	if (Framework_InterruptContext()) {
-		return k_msgq_put(pQueue, ppData, K_NO_WAIT);
+		return QueuePut(pQueue, ppData, K_NO_WAIT);
 	} else {
-		return k_msgq_put(pQueue, ppData, BlockTicks);
+		return QueuePut(pQueue, ppData, BlockTicks);
 	}
 }
 
 BaseType_t Framework_Receive(FwkQueue_t *pQueue, void *ppData,
 			     TickType_t BlockTicks)
 {
-	FRAMEWORK_ASSERT(pQueue != NULL);
-	if (ppData == NULL) {
-		FRAMEWORK_ASSERT(false);
-		return FWK_ERROR;
+	BaseType_t result = ReceiveEntry(pQueue, ppData, BlockTicks);
+
+#if defined(CONFIG_FWK_INLINE_MSGS) || defined(CONFIG_FWK_STATIC_PERIODIC)
+	FwkMsg_t **ppMsg = (FwkMsg_t **)ppData;
+	FwkMsg_t *pCopy;
+	if (result != FWK_SUCCESS || *ppMsg == NULL) {
+		return result;
 	}
+#endif
 
-	if (Framework_InterruptContext()) {
-		return k_msgq_get(pQueue, ppData, K_NO_WAIT);
-	} else {
-		return k_msgq_get(pQueue, ppData, BlockTicks);
+#ifdef CONFIG_FWK_INLINE_MSGS
+	/* The caller gets a buffer that it can free (as for a FIFO). */
+	if (IS_INLINE_ENTRY(*ppMsg)) {
+		FwkMsg_t inlineMsg;
+		pCopy = BufferPool_TakeUninit(sizeof(FwkMsg_t));
+		if (pCopy == NULL) {
+			*ppMsg = NULL;
+			return FWK_ERROR;
+		}
+		Framework_ExpandInline(*ppMsg, &inlineMsg);
+		pCopy->header = inlineMsg.header;
+		pCopy->header.options &= ~FWK_MSG_OPTION_INLINE;
+		*ppMsg = pCopy;
 	}
+#endif
+
+#ifdef CONFIG_FWK_STATIC_PERIODIC
+	/* The caller doesn't tell the framework when it is done with the
+	 * message, so the periodic message of the task is copied and given
+	 * back to the timer. */
+	if (IS_STATIC_PERIODIC(*ppMsg)) {
+		pCopy = BufferPool_TakeUninit(sizeof(FwkPeriodicMsg_t));
+		if (pCopy != NULL) {
+			memcpy(pCopy, *ppMsg, sizeof(FwkPeriodicMsg_t));
+			pCopy->header.options &= ~FWK_MSG_OPTION_STATIC;
+		}
+		FreeMsg(*ppMsg);
+		*ppMsg = pCopy;
+		if (pCopy == NULL) {
+			return FWK_ERROR;
+		}
+	}
+#endif
+
+	return result;
+}
+
+#ifdef CONFIG_FWK_INLINE_MSGS
+BaseType_t Framework_ReceiveEntry(FwkQueue_t *pQueue, void *ppData,
+				  TickType_t BlockTicks)
+{
+	return ReceiveEntry(pQueue, ppData, BlockTicks);
+}
+
+FwkMsg_t *Framework_ExpandInline(FwkMsg_t *pEntry, FwkMsg_t *pStorage)
+{
+	uintptr_t entry = (uintptr_t)pEntry;
+
+	if (!IS_INLINE_ENTRY(pEntry)) {
+		return pEntry;
+	}
+
+	pStorage->header.msgCode = (FwkMsgCode_t)(entry >> 8);
+	pStorage->header.txId = (FwkId_t)(entry >> 16);
+	pStorage->header.rxId = (FwkId_t)(entry >> 24);
+	pStorage->header.options =
+		(uint8_t)((entry >> 1) & INLINE_OPTIONS_MASK) |
+		FWK_MSG_OPTION_INLINE;
+	return pStorage;
+}
+#endif
+
+#ifdef CONFIG_FWK_LATENCY_STATS
+const struct FwkLatencyStats *Framework_GetLatencyStats(FwkId_t RxId)
+{
+	if (RxId >= CONFIG_FWK_MAX_MSG_RECEIVERS) {
+		return NULL;
+	}
+	return &latencyStats[RxId];
+}
+
+void Framework_ResetLatencyStats(FwkId_t RxId)
+{
+	if (RxId < CONFIG_FWK_MAX_MSG_RECEIVERS) {
+		k_spinlock_key_t key = k_spin_lock(&latencyLock[RxId]);
+		memset(&latencyStats[RxId], 0, sizeof(struct FwkLatencyStats));
+		k_spin_unlock(&latencyLock[RxId], key);
+	}
+}
+#endif
+
+#ifdef CONFIG_FWK_MSG_PROFILER
+BaseType_t Framework_GetMsgProfile(FwkMsgCode_t MsgCode,
+				   struct FwkMsgProfile *pProfile)
+{
+	if (MsgCode >= NUMBER_OF_FRAMEWORK_MSG_CODES || pProfile == NULL) {
+		return FWK_ERROR;
+	}
+
+	k_spinlock_key_t key = k_spin_lock(&msgProfileLock);
+	*pProfile = msgProfile[MsgCode];
+	k_spin_unlock(&msgProfileLock, key);
+
+	return FWK_SUCCESS;
+}
+
+void Framework_ResetMsgProfile(void)
+{
+	k_spinlock_key_t key = k_spin_lock(&msgProfileLock);
+	memset(msgProfile, 0, sizeof(msgProfile));
+	k_spin_unlock(&msgProfileLock, key);
 }
+#endif
 
 void Framework_StartTimer(FwkMsgTask_t *pMsgTask)
 {
@@ -250,87 +788,1787 @@ void Framework_ChangeTimerPeriod(FwkMsgTask_t *pMsgTask, TickType_t Duration,
 		      pMsgTask->timerPeriodTicks);
 }
 
-void Framework_MsgReceiver(FwkMsgReceiver_t *pRxer)
+size_t Framework_MsgReceiver(FwkMsgReceiver_t *pRxer)
 {
 	FRAMEWORK_ASSERT(pRxer != NULL);
 
-	FwkMsg_t *pMsg = NULL;
-	BaseType_t status =
-		Framework_Receive(pRxer->pQueue, &pMsg, pRxer->rxBlockTicks);
-
-	if ((status == FWK_SUCCESS) && (pMsg != NULL)) {
-		FwkMsgHandler_t *msgHandler =
-			pRxer->pMsgDispatcher(pMsg->header.msgCode);
-		if (msgHandler != NULL) {
-			DispatchResult_t result = msgHandler(pRxer, pMsg);
-			if (pMsg->header.options & FWK_MSG_OPTION_CALLBACK) {
-				FwkCallbackMsg_t *pCbMsg =
-					(FwkCallbackMsg_t *)pMsg;
-				if (pCbMsg->callback != NULL) {
-					pCbMsg->callback(pCbMsg->data);
-				}
-			}
-			if (result != DISPATCH_DO_NOT_FREE) {
-				BufferPool_Free(pMsg);
-			}
-		} else {
-			Framework_UnknownMsgHandler(pRxer, pMsg);
+	size_t handled = 0;
+	size_t limit = MAX(pRxer->maxBatch, 1);
+	TickType_t blockTicks = pRxer->rxBlockTicks;
+	FwkMsg_t *pMsg;
+	BaseType_t status;
+#ifdef CONFIG_FWK_INLINE_MSGS
+	FwkMsg_t inlineMsg;
+#endif
+
+	while (handled < limit) {
+		pMsg = NULL;
+		status = ReceiveFromLanes(pRxer, &pMsg, blockTicks);
+		if ((status != FWK_SUCCESS) || (pMsg == NULL)) {
+			break;
 		}
+#ifdef CONFIG_FWK_INLINE_MSGS
+		pMsg = Framework_ExpandInline(pMsg, &inlineMsg);
+#endif
+
+		PrepareToDispatch(pMsg);
+		Dispatch(pRxer, pMsg);
+		handled += 1;
+
+		/* Only wait for the first message of a batch. */
+		blockTicks = K_NO_WAIT;
 	}
+
+	return handled;
 }
 
-BaseType_t Framework_QueueIsEmpty(FwkId_t RxId)
+#ifdef CONFIG_FWK_WORKER_POOL
+void Framework_RegisterWorkerPool(FwkMsgWorkerPool_t *pPool)
 {
-	if (RxId >= CONFIG_FWK_MAX_MSG_RECEIVERS) {
-		return 1;
-	}
-	if (!msgTaskRegistry[RxId].inUse) {
-		return 1;
-	}
+	FRAMEWORK_ASSERT(pPool != NULL);
+	k_mutex_init(&pPool->receive);
+	k_mutex_init(&pPool->lock);
+	k_mutex_init(&pPool->serial);
+	k_condvar_init(&pPool->done);
+	memset(pPool->nextTicket, 0, sizeof(pPool->nextTicket));
+	memset(pPool->servingTicket, 0, sizeof(pPool->servingTicket));
+	Framework_RegisterReceiver(&pPool->rxer);
+}
 
-	FwkQueue_t *pQueue = msgTaskRegistry[RxId].pMsgReceiver->pQueue;
-	return ((k_msgq_num_used_get(pQueue) == 0) ? 1 : 0);
+void Framework_RegisterWorker(FwkMsgWorkerPool_t *pPool,
+			      FwkMsgWorker_t *pWorker)
+{
+	FRAMEWORK_ASSERT(pPool != NULL);
+	FRAMEWORK_ASSERT(pWorker != NULL);
+	pWorker->rxer = pPool->rxer;
+	pWorker->pPool = pPool;
 }
 
-size_t Framework_Flush(FwkId_t RxId)
+size_t Framework_WorkerReceiver(FwkMsgWorker_t *pWorker)
+{
+	FRAMEWORK_ASSERT(pWorker != NULL);
+
+	FwkMsgWorkerPool_t *pPool = pWorker->pPool;
+	FwkMsg_t *pMsg = NULL;
+	uint8_t key = 0;
+	uint8_t ticket = 0;
+#ifdef CONFIG_FWK_INLINE_MSGS
+	FwkMsg_t inlineMsg;
+#endif
+
+	/* Tickets are taken in the order messages are removed from the queue.
+	 * The ticket lock isn't held while waiting for a message because a
+	 * worker that already has a message needs it to finish. */
+	k_mutex_lock(&pPool->receive, K_FOREVER);
+	BaseType_t status = ReceiveFromLanes(&pPool->rxer, &pMsg,
+					     pPool->rxer.rxBlockTicks);
+#ifdef CONFIG_FWK_INLINE_MSGS
+	pMsg = Framework_ExpandInline(pMsg, &inlineMsg);
+#endif
+	if (status == FWK_SUCCESS && pMsg != NULL && pPool->orderByTxId) {
+		key = pMsg->header.txId % CONFIG_FWK_MAX_MSG_RECEIVERS;
+		k_mutex_lock(&pPool->lock, K_FOREVER);
+		ticket = pPool->nextTicket[key]++;
+		k_mutex_unlock(&pPool->lock);
+	}
+	k_mutex_unlock(&pPool->receive);
+
+	if ((status != FWK_SUCCESS) || (pMsg == NULL)) {
+		return 0;
+	}
+
+	if (pPool->orderByTxId) {
+		k_mutex_lock(&pPool->lock, K_FOREVER);
+		while (pPool->servingTicket[key] != ticket) {
+			k_condvar_wait(&pPool->done, &pPool->lock, K_FOREVER);
+		}
+		k_mutex_unlock(&pPool->lock);
+	}
+
+	bool reentrant = (pPool->pIsReentrant != NULL) &&
+			 pPool->pIsReentrant(pMsg->header.msgCode);
+
+	PrepareToDispatch(pMsg);
+	if (reentrant) {
+		Dispatch(&pWorker->rxer, pMsg);
+	} else {
+		k_mutex_lock(&pPool->serial, K_FOREVER);
+		Dispatch(&pWorker->rxer, pMsg);
+		k_mutex_unlock(&pPool->serial);
+	}
+
+	if (pPool->orderByTxId) {
+		k_mutex_lock(&pPool->lock, K_FOREVER);
+		pPool->servingTicket[key] += 1;
+		k_condvar_broadcast(&pPool->done);
+		k_mutex_unlock(&pPool->lock);
+	}
+
+	return 1;
+}
+#endif
+
+#ifdef CONFIG_FWK_RECEIVER_QUOTAS
+BaseType_t Framework_GetQuotaUsage(FwkId_t RxId, struct FwkQuotaUsage *pUsage)
+{
+	FRAMEWORK_ASSERT(pUsage != NULL);
+	if (pUsage == NULL || RxId >= CONFIG_FWK_MAX_MSG_RECEIVERS) {
+		return FWK_ERROR;
+	}
+
+	pUsage->bytes = (uint32_t)atomic_get(&quotaUsage[RxId].bytes);
+	pUsage->count = (uint32_t)atomic_get(&quotaUsage[RxId].count);
+	pUsage->rejected = (uint32_t)atomic_get(&quotaUsage[RxId].rejected);
+	pUsage->dropped = (uint32_t)atomic_get(&quotaUsage[RxId].dropped);
+	return FWK_SUCCESS;
+}
+#endif
+
+#ifdef CONFIG_FWK_TRAFFIC_STATS
+uint32_t Framework_GetTraffic(FwkId_t TxId, FwkId_t RxId)
+{
+	if (TxId >= CONFIG_FWK_MAX_MSG_RECEIVERS ||
+	    RxId >= CONFIG_FWK_MAX_MSG_RECEIVERS) {
+		return 0;
+	}
+	return (uint32_t)atomic_get(&traffic[RxId][TxId]);
+}
+
+void Framework_ResetTraffic(void)
+{
+	uint32_t rx;
+	uint32_t tx;
+
+	for (rx = 0; rx < CONFIG_FWK_MAX_MSG_RECEIVERS; rx++) {
+		for (tx = 0; tx < CONFIG_FWK_MAX_MSG_RECEIVERS; tx++) {
+			atomic_clear(&traffic[rx][tx]);
+		}
+	}
+}
+
+BaseType_t Framework_SuggestPlacement(uint8_t *pCpu, uint32_t Cpus)
+{
+	FRAMEWORK_ASSERT(pCpu != NULL);
+	if (pCpu == NULL || Cpus == 0) {
+		return FWK_ERROR;
+	}
+
+	uint32_t load[CONFIG_MP_NUM_CPUS] = { 0 };
+	uint32_t weight[CONFIG_FWK_MAX_MSG_RECEIVERS] = { 0 };
+	bool placed[CONFIG_FWK_MAX_MSG_RECEIVERS] = { false };
+	uint32_t total = 0;
+	uint32_t a;
+	uint32_t b;
+
+	Cpus = MIN(Cpus, CONFIG_MP_NUM_CPUS);
+
+	/* The weight of a receiver is the number of messages it sent and
+	 * handled. */
+	for (a = 0; a < CONFIG_FWK_MAX_MSG_RECEIVERS; a++) {
+		for (b = 0; b < CONFIG_FWK_MAX_MSG_RECEIVERS; b++) {
+			uint32_t count = Framework_GetTraffic(a, b);
+			weight[a] += count;
+			weight[b] += count;
+			total += count;
+		}
+	}
+
+	/* Place the heaviest pair with at least one receiver that
+	 * hasn't been placed.  Join the CPU of the placed receiver unless
+	 * that CPU already has more than its share of the traffic. */
+	while (true) {
+		uint32_t heaviest = 0;
+		uint32_t ha = 0;
+		uint32_t hb = 0;
+
+		for (a = 0; a < CONFIG_FWK_MAX_MSG_RECEIVERS; a++) {
+			for (b = a + 1; b < CONFIG_FWK_MAX_MSG_RECEIVERS; b++) {
+				uint32_t pair = Framework_GetTraffic(a, b) +
+						Framework_GetTraffic(b, a);
+				if (placed[a] && placed[b]) {
+					continue;
+				}
+				if (pair > heaviest) {
+					heaviest = pair;
+					ha = a;
+					hb = b;
+				}
+			}
+		}
+
+		if (heaviest == 0) {
+			break;
+		}
+
+		uint32_t cpu;
+		if (placed[ha] || placed[hb]) {
+			cpu = placed[ha] ? pCpu[ha] : pCpu[hb];
+			if (load[cpu] > (total / Cpus)) {
+				cpu = LeastLoadedCpu(load, Cpus);
+			}
+		} else {
+			cpu = LeastLoadedCpu(load, Cpus);
+		}
+
+		if (!placed[ha]) {
+			pCpu[ha] = cpu;
+			placed[ha] = true;
+			load[cpu] += weight[ha];
+		}
+		if (!placed[hb]) {
+			pCpu[hb] = cpu;
+			placed[hb] = true;
+			load[cpu] += weight[hb];
+		}
+	}
+
+	/* Receivers that only send to themselves (or are idle) */
+	for (a = 0; a < CONFIG_FWK_MAX_MSG_RECEIVERS; a++) {
+		if (!placed[a]) {
+			pCpu[a] = LeastLoadedCpu(load, Cpus);
+			load[pCpu[a]] += weight[a];
+		}
+	}
+
+	return FWK_SUCCESS;
+}
+#endif
+
+#ifdef CONFIG_FWK_MUX
+size_t Framework_MuxReceiver(FwkMsgMux_t *pMux, TickType_t BlockTicks)
+{
+	FRAMEWORK_ASSERT(pMux != NULL);
+
+	size_t handled = MuxServiceReady(pMux);
+	if (handled > 0 || K_TIMEOUT_EQ(BlockTicks, K_NO_WAIT)) {
+		return handled;
+	}
+
+	size_t events = 0;
+	size_t i;
+	for (i = 0; i < pMux->count; i++) {
+		FwkMsgReceiver_t *pRxer = pMux->ppReceivers[i];
+#ifdef CONFIG_FWK_URGENT_QUEUE
+		if (pRxer->pUrgentQueue != NULL) {
+			QueuePollEventInit(&pMux->pEvents[events++],
+					   pRxer->pUrgentQueue);
+		}
+#endif
+		QueuePollEventInit(&pMux->pEvents[events++], pRxer->pQueue);
+	}
+
+	if (k_poll(pMux->pEvents, events, BlockTicks) != 0) {
+		return 0;
+	}
+
+	return MuxServiceReady(pMux);
+}
+#endif
+
+BaseType_t Framework_QueueIsEmpty(FwkId_t RxId)
+{
+	if (RxId >= CONFIG_FWK_MAX_MSG_RECEIVERS) {
+		return 1;
+	}
+	if (!msgTaskRegistry[RxId].inUse) {
+		return 1;
+	}
+
+	FwkMsgReceiver_t *pMsgRxer = msgTaskRegistry[RxId].pMsgReceiver;
+	bool empty = QueueIsEmpty(pMsgRxer->pQueue);
+#ifdef CONFIG_FWK_URGENT_QUEUE
+	if (pMsgRxer->pUrgentQueue != NULL) {
+		empty = empty && QueueIsEmpty(pMsgRxer->pUrgentQueue);
+	}
+#endif
+	return (empty ? 1 : 0);
+}
+
+size_t Framework_Flush(FwkId_t RxId)
 {
 	if (RxId >= CONFIG_FWK_MAX_MSG_RECEIVERS) {
 		return 0;
 	}
-	if (!msgTaskRegistry[RxId].inUse) {
-		return 0;
+	if (!msgTaskRegistry[RxId].inUse) {
+		return 0;
+	}
+
+	FwkMsgReceiver_t *pMsgRxer = msgTaskRegistry[RxId].pMsgReceiver;
+	size_t purged = FlushQueue(pMsgRxer->pQueue);
+#ifdef CONFIG_FWK_URGENT_QUEUE
+	if (pMsgRxer->pUrgentQueue != NULL) {
+		purged += FlushQueue(pMsgRxer->pUrgentQueue);
+	}
+#endif
+	return purged;
+}
+
+size_t Framework_FlushMatching(FwkId_t RxId, FwkMsgMatch_t *pMatch,
+			       void *pContext)
+{
+	FRAMEWORK_ASSERT(pMatch != NULL);
+	return ScanReceiver(RxId, pMatch, pContext, true);
+}
+
+size_t Framework_FlushCode(FwkId_t RxId, FwkMsgCode_t MsgCode)
+{
+	return ScanReceiver(RxId, MatchCode, &MsgCode, true);
+}
+
+size_t Framework_CountMatching(FwkId_t RxId, FwkMsgMatch_t *pMatch,
+			       void *pContext)
+{
+	FRAMEWORK_ASSERT(pMatch != NULL);
+	return ScanReceiver(RxId, pMatch, pContext, false);
+}
+
+size_t Framework_CountCode(FwkId_t RxId, FwkMsgCode_t MsgCode)
+{
+	return ScanReceiver(RxId, MatchCode, &MsgCode, false);
+}
+
+/******************************************************************************/
+/* Local Function Definitions                                                 */
+/******************************************************************************/
+/**
+ * @brief Initialize buffer pool (statistics).
+ */
+static int Framework_Initialize(const struct device *device)
+{
+	ARG_UNUSED(device);
+
+	BufferPool_Initialize();
+
+#ifdef CONFIG_FWK_RECEIVER_QUOTAS
+	BufferPool_SetReleaseHandler(QuotaRelease);
+#endif
+
+	return 0;
+}
+
+/**
+ * @brief Queue backend wrappers.  A queue is a Zephyr message queue unless
+ * other queue types are enabled (then the type is chosen per queue).
+ */
+static int QueuePut(FwkQueue_t *pQueue, void *ppData, TickType_t BlockTicks)
+{
+#ifdef CONFIG_FWK_QUEUE_TYPES
+	switch (pQueue->type) {
+#ifdef CONFIG_FWK_QUEUE_SPSC
+	case FWK_QUEUE_TYPE_SPSC:
+		return SpscPut(&pQueue->spsc, ppData, BlockTicks);
+#endif
+#ifdef CONFIG_FWK_QUEUE_FIFO
+	case FWK_QUEUE_TYPE_FIFO:
+		k_fifo_put(&pQueue->fifo,
+			   BufferPool_GetNode(*((void **)ppData)));
+		return 0;
+#endif
+	default:
+		return k_msgq_put(&pQueue->msgq, ppData, BlockTicks);
+	}
+#else
+	return k_msgq_put(pQueue, ppData, BlockTicks);
+#endif
+}
+
+static int QueueGet(FwkQueue_t *pQueue, void *ppData, TickType_t BlockTicks)
+{
+#ifdef CONFIG_FWK_QUEUE_TYPES
+	switch (pQueue->type) {
+#ifdef CONFIG_FWK_QUEUE_SPSC
+	case FWK_QUEUE_TYPE_SPSC:
+		return SpscGet(&pQueue->spsc, ppData, BlockTicks);
+#endif
+#ifdef CONFIG_FWK_QUEUE_FIFO
+	case FWK_QUEUE_TYPE_FIFO: {
+		void *pNode = k_fifo_get(&pQueue->fifo, BlockTicks);
+		if (pNode == NULL) {
+			return -EAGAIN;
+		}
+		*((void **)ppData) = BufferPool_FromNode(pNode);
+		return 0;
+	}
+#endif
+	default:
+		return k_msgq_get(&pQueue->msgq, ppData, BlockTicks);
+	}
+#else
+	return k_msgq_get(pQueue, ppData, BlockTicks);
+#endif
+}
+
+static bool QueueIsEmpty(FwkQueue_t *pQueue)
+{
+#ifdef CONFIG_FWK_QUEUE_TYPES
+	switch (pQueue->type) {
+#ifdef CONFIG_FWK_QUEUE_SPSC
+	case FWK_QUEUE_TYPE_SPSC:
+		return atomic_get(&pQueue->spsc.head) ==
+		       atomic_get(&pQueue->spsc.tail);
+#endif
+#ifdef CONFIG_FWK_QUEUE_FIFO
+	case FWK_QUEUE_TYPE_FIFO:
+		return k_fifo_is_empty(&pQueue->fifo);
+#endif
+	default:
+		return k_msgq_num_used_get(&pQueue->msgq) == 0;
+	}
+#else
+	return k_msgq_num_used_get(pQueue) == 0;
+#endif
+}
+
+/**
+ * @brief Queue a message to a receiver.  Buffers are charged to the receiver
+ * when quotas are enabled.
+ */
+static BaseType_t QueueTo(FwkMsgReceiver_t *pMsgRxer, FwkMsg_t *pMsg,
+			  TickType_t Timeout)
+{
+	FwkQueue_t *pQueue = SelectQueue(pMsgRxer, pMsg);
+
+	/* Static and inline messages don't use a buffer. */
+	if (!(pMsg->header.options &
+	      (FWK_MSG_OPTION_STATIC | FWK_MSG_OPTION_INLINE))) {
+#ifdef CONFIG_FWK_LATENCY_STATS
+		BufferPool_SetTimestamp(pMsg, LATENCY_STAMP());
+#endif
+#ifdef CONFIG_FWK_RECEIVER_QUOTAS
+		return QueueCharged(pMsgRxer, pQueue, pMsg, Timeout);
+#endif
+	}
+
+	return Framework_Queue(pQueue, &pMsg, Timeout);
+}
+
+#ifdef CONFIG_FWK_RECEIVER_QUOTAS
+/**
+ * @brief Move the charge for a buffer to the receiver and then queue it.
+ * The charge is released when the buffer is freed (or forwarded).
+ */
+static BaseType_t QueueCharged(FwkMsgReceiver_t *pMsgRxer, FwkQueue_t *pQueue,
+			       FwkMsg_t *pMsg, TickType_t Timeout)
+{
+	FwkId_t id = pMsgRxer->id;
+	uint8_t prev = BufferPool_GetOwner(pMsg);
+	size_t size;
+	bool fits;
+	BaseType_t result;
+
+	/* A receiver is sending a message to itself */
+	if (prev == QUOTA_OWNER(id)) {
+		return Framework_Queue(pQueue, &pMsg, Timeout);
+	}
+
+	size = BufferPool_GetSize(pMsg);
+	/* Dropping queued messages can't make room for a message that is
+	 * larger than the quota. */
+	fits = (pMsgRxer->quotaBytes == 0 || size <= pMsgRxer->quotaBytes);
+	while (!QuotaCharge(pMsgRxer, size)) {
+		if (pMsgRxer->quotaPolicy == FWK_QUOTA_DROP_NEWEST) {
+			atomic_inc(&quotaUsage[id].dropped);
+			DiscardMsg(pMsg);
+			return FWK_SUCCESS;
+		}
+		if (pMsgRxer->quotaPolicy != FWK_QUOTA_DROP_OLDEST || !fits ||
+		    !DropOldest(pQueue, QUOTA_OWNER(id))) {
+			atomic_inc(&quotaUsage[id].rejected);
+			return FWK_ERROR;
+		}
+		atomic_inc(&quotaUsage[id].dropped);
+	}
+
+	BufferPool_SetOwner(pMsg, QUOTA_OWNER(id));
+	if (prev != 0) {
+		QuotaRelease(prev, size);
+	}
+
+	result = Framework_Queue(pQueue, &pMsg, Timeout);
+	if (result != FWK_SUCCESS) {
+		BufferPool_SetOwner(pMsg, 0);
+		QuotaRelease(QUOTA_OWNER(id), size);
+	}
+	return result;
+}
+
+/**
+ * @retval false if the buffer would exceed a quota of the receiver (nothing
+ * is charged).
+ */
+static bool QuotaCharge(FwkMsgReceiver_t *pMsgRxer, size_t Size)
+{
+	FwkId_t id = pMsgRxer->id;
+	uint32_t bytes = (uint32_t)atomic_add(&quotaUsage[id].bytes, Size);
+	uint32_t count = (uint32_t)atomic_inc(&quotaUsage[id].count);
+
+	/* atomic_add and atomic_inc return the previous value */
+	bytes += Size;
+	count += 1;
+
+	if ((pMsgRxer->quotaBytes != 0 && bytes > pMsgRxer->quotaBytes) ||
+	    (pMsgRxer->quotaCount != 0 && count > pMsgRxer->quotaCount)) {
+		QuotaRelease(QUOTA_OWNER(id), Size);
+		return false;
+	}
+	return true;
+}
+
+/**
+ * @brief Buffer pool release handler.
+ */
+static void QuotaRelease(uint8_t Owner, size_t Size)
+{
+	atomic_sub(&quotaUsage[Owner - 1].bytes, Size);
+	atomic_dec(&quotaUsage[Owner - 1].count);
+}
+
+/**
+ * @brief Free the oldest message in a queue if it is charged to the owner.
+ * Other messages (inline, static or charged to another receiver) don't free
+ * any of the quota, so they are kept.
+ *
+ * @retval false if nothing was freed.  A single producer, single consumer
+ * ring can only be read by its receiver.
+ */
+static bool DropOldest(FwkQueue_t *pQueue, uint8_t Owner)
+{
+#ifdef CONFIG_FWK_QUEUE_TYPES
+	switch (pQueue->type) {
+#ifdef CONFIG_FWK_QUEUE_SPSC
+	case FWK_QUEUE_TYPE_SPSC:
+		return false;
+#endif
+#ifdef CONFIG_FWK_QUEUE_FIFO
+	case FWK_QUEUE_TYPE_FIFO:
+		return DropOldestFifo(&pQueue->fifo, Owner);
+#endif
+	default:
+		return DropOldestMsgq(&pQueue->msgq, Owner);
+	}
+#else
+	return DropOldestMsgq(pQueue, Owner);
+#endif
+}
+
+/**
+ * @brief The head is checked and removed with the queue locked, so the
+ * receiver can't take (and free) it in between.
+ */
+static bool DropOldestMsgq(struct k_msgq *pMsgq, uint8_t Owner)
+{
+	k_spinlock_key_t key = k_spin_lock(&pMsgq->lock);
+	FwkMsg_t *pMsg = NULL;
+
+	if (pMsgq->used_msgs > 0) {
+		memcpy(&pMsg, pMsgq->read_ptr, sizeof(pMsg));
+	}
+	if (!IsCharged(pMsg, Owner)) {
+		k_spin_unlock(&pMsgq->lock, key);
+		return false;
+	}
+	MsgqRemoveHead(pMsgq, 1, key);
+
+	DiscardMsg(pMsg);
+	return true;
+}
+
+#ifdef CONFIG_FWK_QUEUE_FIFO
+static bool DropOldestFifo(struct k_fifo *pFifo, uint8_t Owner)
+{
+	struct k_queue *pKQueue = &pFifo->_queue;
+	k_spinlock_key_t key = k_spin_lock(&pKQueue->lock);
+	sys_sfnode_t *pNode = sys_sflist_peek_head(&pKQueue->data_q);
+	FwkMsg_t *pMsg = NULL;
+
+	if (pNode != NULL) {
+		pMsg = BufferPool_FromNode(pNode);
+	}
+	if (!IsCharged(pMsg, Owner)) {
+		k_spin_unlock(&pKQueue->lock, key);
+		return false;
+	}
+	sys_sflist_remove(&pKQueue->data_q, NULL, pNode);
+	k_spin_unlock(&pKQueue->lock, key);
+
+	DiscardMsg(pMsg);
+	return true;
+}
+#endif
+
+/**
+ * @param pEntry queue entry (can be NULL)
+ */
+static bool IsCharged(FwkMsg_t *pEntry, uint8_t Owner)
+{
+	if (pEntry == NULL) {
+		return false;
+	}
+#ifdef CONFIG_FWK_INLINE_MSGS
+	if (IS_INLINE_ENTRY(pEntry)) {
+		return false;
+	}
+#endif
+	if (pEntry->header.options &
+	    (FWK_MSG_OPTION_STATIC | FWK_MSG_OPTION_INLINE)) {
+		return false;
+	}
+	return BufferPool_GetOwner(pEntry) == Owner;
+}
+#endif
+
+#ifdef CONFIG_FWK_INLINE_MSGS
+/**
+ * @brief Put the header of an inline message into a queue entry.
+ */
+static BaseType_t QueueInline(FwkQueue_t *pQueue, FwkMsg_t *pMsg,
+			      TickType_t BlockTicks)
+{
+	FwkMsg_t *pEntry;
+
+#ifdef CONFIG_FWK_QUEUE_FIFO
+	/* FIFO entries are linked through the buffer pool header. */
+	if (pQueue->type == FWK_QUEUE_TYPE_FIFO) {
+		BaseType_t result = FWK_ERROR;
+		pEntry = BufferPool_TakeUninit(sizeof(FwkMsg_t));
+		if (pEntry != NULL) {
+			pEntry->header = pMsg->header;
+			pEntry->header.options &= ~FWK_MSG_OPTION_INLINE;
+			result = Framework_Queue(pQueue, &pEntry, BlockTicks);
+			if (result != FWK_SUCCESS) {
+				BufferPool_Free(pEntry);
+			}
+		}
+		return result;
+	}
+#endif
+
+	pEntry = INLINE_ENTRY(pMsg->header);
+	if (Framework_InterruptContext()) {
+		return QueuePut(pQueue, &pEntry, K_NO_WAIT);
+	} else {
+		return QueuePut(pQueue, &pEntry, BlockTicks);
+	}
+}
+#endif
+
+#ifdef POLL_QUEUES
+/**
+ * @brief Prepare an event used to wait for a queue to have data.
+ */
+static void QueuePollEventInit(struct k_poll_event *pEvent, FwkQueue_t *pQueue)
+{
+#ifdef CONFIG_FWK_QUEUE_TYPES
+	switch (pQueue->type) {
+#ifdef CONFIG_FWK_QUEUE_SPSC
+	case FWK_QUEUE_TYPE_SPSC:
+		/* The producer only gives the semaphore when asked to.
+		 * Drop a stale give (it would end every poll immediately),
+		 * ask and then check for an entry put before the request. */
+		k_sem_reset(&pQueue->spsc.available);
+		atomic_set(&pQueue->spsc.waiting, 1);
+		if (atomic_get(&pQueue->spsc.head) !=
+		    atomic_get(&pQueue->spsc.tail)) {
+			k_sem_give(&pQueue->spsc.available);
+		}
+		k_poll_event_init(pEvent, K_POLL_TYPE_SEM_AVAILABLE,
+				  K_POLL_MODE_NOTIFY_ONLY,
+				  &pQueue->spsc.available);
+		break;
+#endif
+#ifdef CONFIG_FWK_QUEUE_FIFO
+	case FWK_QUEUE_TYPE_FIFO:
+		k_poll_event_init(pEvent, K_POLL_TYPE_FIFO_DATA_AVAILABLE,
+				  K_POLL_MODE_NOTIFY_ONLY, &pQueue->fifo);
+		break;
+#endif
+	default:
+		k_poll_event_init(pEvent, K_POLL_TYPE_MSGQ_DATA_AVAILABLE,
+				  K_POLL_MODE_NOTIFY_ONLY, &pQueue->msgq);
+		break;
+	}
+#else
+	k_poll_event_init(pEvent, K_POLL_TYPE_MSGQ_DATA_AVAILABLE,
+			  K_POLL_MODE_NOTIFY_ONLY, pQueue);
+#endif
+}
+#endif
+
+#ifdef CONFIG_FWK_QUEUE_SPSC
+/**
+ * @brief Put an entry into a single producer, single consumer ring.
+ * Head is only written by the producer and tail is only written by the
+ * consumer.  The atomic write of head publishes the entry.
+ *
+ * @retval 0 on success, -ENOMSG if the ring is full and BlockTicks is zero,
+ * -EAGAIN if waiting timed out
+ */
+static int SpscPut(struct FwkSpscRing *pRing, void *ppData,
+		   TickType_t BlockTicks)
+{
+	atomic_val_t head = atomic_get(&pRing->head);
+	uint32_t used;
+	void *pProducer = Framework_InterruptContext() ?
+				  SPSC_ISR_PRODUCER :
+				  (void *)k_current_get();
+
+	/* A second producer would corrupt head */
+	if (!atomic_ptr_cas(&pRing->producer, NULL, pProducer)) {
+		FRAMEWORK_ASSERT(atomic_ptr_get(&pRing->producer) == pProducer);
+	}
+
+	while (true) {
+		used = (uint32_t)(head - atomic_get(&pRing->tail));
+		if (used <= pRing->mask) {
+			pRing->ppEntries[head & pRing->mask] =
+				*((void **)ppData);
+			atomic_set(&pRing->head, head + 1);
+
+			/* Only enter the kernel when the consumer is
+			 * (or is about to be) waiting for data. */
+			if (atomic_cas(&pRing->waiting, 1, 0)) {
+				k_sem_give(&pRing->available);
+			}
+			return 0;
+		}
+
+		if (K_TIMEOUT_EQ(BlockTicks, K_NO_WAIT)) {
+			return -ENOMSG;
+		}
+
+		/* Ask the consumer to signal, then check again so that an
+		 * entry taken before the request isn't missed. */
+		atomic_set(&pRing->spaceWaiting, 1);
+		used = (uint32_t)(head - atomic_get(&pRing->tail));
+		if (used <= pRing->mask) {
+			atomic_clear(&pRing->spaceWaiting);
+			continue;
+		}
+
+		if (k_sem_take(&pRing->space, BlockTicks) != 0) {
+			atomic_clear(&pRing->spaceWaiting);
+			return -EAGAIN;
+		}
+	}
+}
+
+/**
+ * @brief Get an entry from a single producer, single consumer ring.
+ *
+ * @retval 0 on success, -ENOMSG if ring is empty and BlockTicks is zero,
+ * -EAGAIN if waiting timed out
+ */
+static int SpscGet(struct FwkSpscRing *pRing, void *ppData,
+		   TickType_t BlockTicks)
+{
+	atomic_val_t tail = atomic_get(&pRing->tail);
+
+	while (true) {
+		if (atomic_get(&pRing->head) != tail) {
+			*((void **)ppData) =
+				pRing->ppEntries[tail & pRing->mask];
+			atomic_set(&pRing->tail, tail + 1);
+
+			if (atomic_cas(&pRing->spaceWaiting, 1, 0)) {
+				k_sem_give(&pRing->space);
+			}
+			return 0;
+		}
+
+		if (K_TIMEOUT_EQ(BlockTicks, K_NO_WAIT)) {
+			return -ENOMSG;
+		}
+
+		/* Ask the producer to signal, then check again so that an
+		 * entry put before the request isn't missed. */
+		atomic_set(&pRing->waiting, 1);
+		if (atomic_get(&pRing->head) != tail) {
+			atomic_clear(&pRing->waiting);
+			continue;
+		}
+
+		/* A stale give (from an earlier wait) causes another pass. */
+		if (k_sem_take(&pRing->available, BlockTicks) != 0) {
+			atomic_clear(&pRing->waiting);
+			return -EAGAIN;
+		}
+	}
+}
+#endif
+
+/**
+ * @brief Select the urgent queue when the message requests it and the
+ * receiver has one.
+ */
+static FwkQueue_t *SelectQueue(FwkMsgReceiver_t *pMsgRxer, FwkMsg_t *pMsg)
+{
+#ifdef CONFIG_FWK_URGENT_QUEUE
+	if ((pMsg->header.options & FWK_MSG_OPTION_URGENT) &&
+	    (pMsgRxer->pUrgentQueue != NULL)) {
+		return pMsgRxer->pUrgentQueue;
+	}
+#else
+	ARG_UNUSED(pMsg);
+#endif
+	return pMsgRxer->pQueue;
+}
+
+/**
+ * @brief Take an entry from a queue.  An inline entry isn't unpacked.
+ */
+static BaseType_t ReceiveEntry(FwkQueue_t *pQueue, void *ppData,
+			       TickType_t BlockTicks)
+{
+	FRAMEWORK_ASSERT(pQueue != NULL);
+	if (ppData == NULL) {
+		FRAMEWORK_ASSERT(false);
+		return FWK_ERROR;
+	}
+
+	BaseType_t result;
+	if (Framework_InterruptContext()) {
+		result = QueueGet(pQueue, ppData, K_NO_WAIT);
+	} else {
+		result = QueueGet(pQueue, ppData, BlockTicks);
+	}
+
+#ifdef CONFIG_FWK_COALESCE_PERIODIC
+	/* Tasks that receive (and dispatch) messages themselves must also
+	 * release the periodic timer. */
+	FwkMsg_t *pMsg = *((FwkMsg_t **)ppData);
+	if (result == FWK_SUCCESS && pMsg != NULL
+#ifdef CONFIG_FWK_INLINE_MSGS
+	    && !IS_INLINE_ENTRY(pMsg)
+#endif
+	    && (pMsg->header.options & FWK_MSG_OPTION_PERIODIC)) {
+		ReleasePeriodic(pMsg);
+	}
+#endif
+
+	return result;
+}
+
+/**
+ * @brief Receive a message from the urgent queue if it isn't empty.
+ * Otherwise, receive from the normal queue.  Inline entries aren't
+ * unpacked.
+ */
+static BaseType_t ReceiveFromLanes(FwkMsgReceiver_t *pRxer, FwkMsg_t **ppMsg,
+				   TickType_t BlockTicks)
+{
+#ifdef CONFIG_FWK_URGENT_QUEUE
+	if (pRxer->pUrgentQueue != NULL) {
+		struct k_poll_event events[2];
+		int status;
+
+		if (ReceiveEntry(pRxer->pUrgentQueue, ppMsg, K_NO_WAIT) ==
+		    FWK_SUCCESS) {
+			return FWK_SUCCESS;
+		}
+
+		if (Framework_InterruptContext() ||
+		    K_TIMEOUT_EQ(BlockTicks, K_NO_WAIT)) {
+			return ReceiveEntry(pRxer->pQueue, ppMsg, K_NO_WAIT);
+		}
+
+		/* Wait on both queues and then check them in priority order. */
+		QueuePollEventInit(&events[0], pRxer->pUrgentQueue);
+		QueuePollEventInit(&events[1], pRxer->pQueue);
+		status = k_poll(events, ARRAY_SIZE(events), BlockTicks);
+		if (status != 0) {
+			return status;
+		}
+
+		if (ReceiveEntry(pRxer->pUrgentQueue, ppMsg, K_NO_WAIT) ==
+		    FWK_SUCCESS) {
+			return FWK_SUCCESS;
+		}
+		return ReceiveEntry(pRxer->pQueue, ppMsg, K_NO_WAIT);
+	}
+#endif
+	return ReceiveEntry(pRxer->pQueue, ppMsg, BlockTicks);
+}
+
+/**
+ * @brief Free all messages in a queue.
+ */
+static size_t FlushQueue(FwkQueue_t *pQueue)
+{
+	FwkMsg_t *pMsg;
+	size_t purged = 0;
+#ifdef CONFIG_FWK_INLINE_MSGS
+	FwkMsg_t inlineMsg;
+#endif
+	while (true) {
+		pMsg = NULL;
+		QueueGet(pQueue, &pMsg, K_NO_WAIT);
+		if (pMsg != NULL) {
+#ifdef CONFIG_FWK_INLINE_MSGS
+			pMsg = Framework_ExpandInline(pMsg, &inlineMsg);
+#endif
+			DiscardMsg(pMsg);
+			purged += 1;
+		} else {
+			break;
+		}
+	}
+	return purged;
+}
+
+/**
+ * @brief Count (and optionally discard) the matching messages in the queues
+ * of a receiver.
+ */
+static size_t ScanReceiver(FwkId_t RxId, FwkMsgMatch_t *pMatch,
+			   void *pContext, bool Discard)
+{
+	if (pMatch == NULL || RxId >= CONFIG_FWK_MAX_MSG_RECEIVERS) {
+		return 0;
+	}
+	if (!msgTaskRegistry[RxId].inUse) {
+		return 0;
+	}
+
+	FwkMsgReceiver_t *pMsgRxer = msgTaskRegistry[RxId].pMsgReceiver;
+	size_t matched = ScanQueue(pMsgRxer->pQueue, pMatch, pContext, Discard);
+#ifdef CONFIG_FWK_URGENT_QUEUE
+	if (pMsgRxer->pUrgentQueue != NULL) {
+		matched += ScanQueue(pMsgRxer->pUrgentQueue, pMatch, pContext,
+				     Discard);
+	}
+#endif
+	return matched;
+}
+
+static size_t ScanQueue(FwkQueue_t *pQueue, FwkMsgMatch_t *pMatch,
+			void *pContext, bool Discard)
+{
+#ifdef CONFIG_FWK_QUEUE_TYPES
+	switch (pQueue->type) {
+#ifdef CONFIG_FWK_QUEUE_SPSC
+	case FWK_QUEUE_TYPE_SPSC:
+		return ScanSpsc(&pQueue->spsc, pMatch, pContext, Discard);
+#endif
+#ifdef CONFIG_FWK_QUEUE_FIFO
+	case FWK_QUEUE_TYPE_FIFO:
+		return ScanFifo(&pQueue->fifo, pMatch, pContext, Discard);
+#endif
+	default:
+		return ScanMsgq(&pQueue->msgq, pMatch, pContext, Discard);
+	}
+#else
+	return ScanMsgq(pQueue, pMatch, pContext, Discard);
+#endif
+}
+
+/**
+ * @brief Walk the ring buffer of a Zephyr message queue.
+ *
+ * The entries are copied while the queue is locked and matched after it is
+ * unlocked.  To discard, the queue is locked again and the matching entries
+ * that are still queued are removed in one step.  The entries that are kept
+ * are moved toward the write pointer (in order), the read pointer is moved
+ * past the removed entries and threads that are blocked sending to the
+ * queue are given the space (as k_msgq_get does).
+ */
+static size_t ScanMsgq(struct k_msgq *pMsgq, FwkMsgMatch_t *pMatch,
+		       void *pContext, bool Discard)
+{
+	k_spinlock_key_t key;
+	FwkMsg_t **ppBatch;
+	uint32_t count;
+	uint32_t used;
+	size_t matched = 0;
+	size_t removed = 0;
+	size_t n;
+	char *pRead;
+	char *pKeep;
+	FwkMsg_t *pEntry;
+	FwkMsg_t *pMsg;
+#ifdef CONFIG_FWK_INLINE_MSGS
+	FwkMsg_t inlineMsg;
+#endif
+
+	ppBatch = BP_TRY_TO_TAKE(pMsgq->max_msgs * sizeof(FwkMsg_t *));
+	if (ppBatch == NULL) {
+		return 0;
+	}
+
+	/* Copy the entries from the oldest to the newest */
+	key = k_spin_lock(&pMsgq->lock);
+	count = pMsgq->used_msgs;
+	pRead = pMsgq->read_ptr;
+	for (n = 0; n < count; n++) {
+		memcpy(&ppBatch[n], pRead, sizeof(FwkMsg_t *));
+		pRead += pMsgq->msg_size;
+		if (pRead == pMsgq->buffer_end) {
+			pRead = pMsgq->buffer_start;
+		}
+	}
+	k_spin_unlock(&pMsgq->lock, key);
+
+	/* The matching entries are moved to the front of the batch */
+	for (n = 0; n < count; n++) {
+		pMsg = ppBatch[n];
+#ifdef CONFIG_FWK_INLINE_MSGS
+		pMsg = Framework_ExpandInline(ppBatch[n], &inlineMsg);
+#endif
+		if (pMatch(pMsg, pContext)) {
+			ppBatch[matched++] = ppBatch[n];
+		}
+	}
+
+	if (!Discard || matched == 0) {
+		BufferPool_Free(ppBatch);
+		return matched;
+	}
+
+	/* Walk from the newest entry to the oldest.  Entries that were
+	 * received after the copy was made aren't found.  Found entries are
+	 * moved to the front of the matches.
+	 */
+	key = k_spin_lock(&pMsgq->lock);
+	used = pMsgq->used_msgs;
+	pRead = pMsgq->write_ptr;
+	pKeep = pMsgq->write_ptr;
+	while (used > 0) {
+		if (pRead == pMsgq->buffer_start) {
+			pRead = pMsgq->buffer_end;
+		}
+		pRead -= pMsgq->msg_size;
+		used -= 1;
+
+		memcpy(&pEntry, pRead, sizeof(pEntry));
+		for (n = removed; n < matched; n++) {
+			if (ppBatch[n] == pEntry) {
+				ppBatch[n] = ppBatch[removed];
+				ppBatch[removed++] = pEntry;
+				break;
+			}
+		}
+		if (n < matched) {
+			continue;
+		}
+
+		if (pKeep == pMsgq->buffer_start) {
+			pKeep = pMsgq->buffer_end;
+		}
+		pKeep -= pMsgq->msg_size;
+		if (pKeep != pRead) {
+			memcpy(pKeep, &pEntry, sizeof(pEntry));
+		}
+	}
+
+	MsgqRemoveHead(pMsgq, removed, key);
+
+	/* Messages are freed (and callers of Framework_Call are woken)
+	 * after the queue is unlocked. */
+	for (n = 0; n < removed; n++) {
+		pMsg = ppBatch[n];
+#ifdef CONFIG_FWK_INLINE_MSGS
+		pMsg = Framework_ExpandInline(ppBatch[n], &inlineMsg);
+#endif
+		DiscardMsg(pMsg);
+	}
+
+	BufferPool_Free(ppBatch);
+	return removed;
+}
+
+/**
+ * @brief Remove entries from the head of a locked message queue, give the
+ * space to threads that are blocked sending to it (as k_msgq_get does) and
+ * unlock it.
+ */
+static void MsgqRemoveHead(struct k_msgq *pMsgq, size_t Count,
+			   k_spinlock_key_t Key)
+{
+	struct k_thread *pSender;
+	bool woken = false;
+	size_t n;
+
+	for (n = 0; n < Count; n++) {
+		pMsgq->read_ptr += pMsgq->msg_size;
+		if (pMsgq->read_ptr == pMsgq->buffer_end) {
+			pMsgq->read_ptr = pMsgq->buffer_start;
+		}
+		pMsgq->used_msgs -= 1;
+
+		pSender = z_unpend_first_thread(&pMsgq->wait_q);
+		if (pSender == NULL) {
+			continue;
+		}
+		memcpy(pMsgq->write_ptr, pSender->base.swap_data,
+		       pMsgq->msg_size);
+		pMsgq->write_ptr += pMsgq->msg_size;
+		if (pMsgq->write_ptr == pMsgq->buffer_end) {
+			pMsgq->write_ptr = pMsgq->buffer_start;
+		}
+		pMsgq->used_msgs += 1;
+		arch_thread_return_value_set(pSender, 0);
+		z_ready_thread(pSender);
+		woken = true;
+	}
+
+	if (woken) {
+		z_reschedule(&pMsgq->lock, Key);
+	} else {
+		k_spin_unlock(&pMsgq->lock, Key);
+	}
+}
+
+#ifdef CONFIG_FWK_QUEUE_SPSC
+/**
+ * @brief Walk a ring from head to tail (consumer only).  Entries that are
+ * kept are moved toward head, so the producer is never affected.  Then tail
+ * is moved forward.
+ */
+static size_t ScanSpsc(struct FwkSpscRing *pRing, FwkMsgMatch_t *pMatch,
+		       void *pContext, bool Discard)
+{
+	atomic_val_t tail = atomic_get(&pRing->tail);
+	atomic_val_t i = atomic_get(&pRing->head);
+	atomic_val_t keep = i;
+	size_t matched = 0;
+	FwkMsg_t *pEntry;
+	FwkMsg_t *pMsg;
+#ifdef CONFIG_FWK_INLINE_MSGS
+	FwkMsg_t inlineMsg;
+#endif
+
+	while (i != tail) {
+		i -= 1;
+		pEntry = pRing->ppEntries[i & pRing->mask];
+		pMsg = pEntry;
+#ifdef CONFIG_FWK_INLINE_MSGS
+		pMsg = Framework_ExpandInline(pEntry, &inlineMsg);
+#endif
+		if (pMatch(pMsg, pContext)) {
+			matched += 1;
+			if (Discard) {
+				DiscardMsg(pMsg);
+				continue;
+			}
+		}
+		keep -= 1;
+		if (keep != i) {
+			pRing->ppEntries[keep & pRing->mask] = pEntry;
+		}
+	}
+
+	if (keep != tail) {
+		atomic_set(&pRing->tail, keep);
+		if (atomic_cas(&pRing->spaceWaiting, 1, 0)) {
+			k_sem_give(&pRing->space);
+		}
+	}
+	return matched;
+}
+#endif
+
+#ifdef CONFIG_FWK_QUEUE_FIFO
+/**
+ * @brief Walk the list of a FIFO.  The nodes are copied while the FIFO is
+ * locked and matched after it is unlocked.  To discard, the matching nodes
+ * that are still queued are unlinked in one step.
+ */
+static size_t ScanFifo(struct k_fifo *pFifo, FwkMsgMatch_t *pMatch,
+		       void *pContext, bool Discard)
+{
+	struct k_queue *pKQueue = &pFifo->_queue;
+	k_spinlock_key_t key;
+	sys_sfnode_t **ppBatch;
+	sys_sfnode_t *pPrev;
+	sys_sfnode_t *pNode;
+	sys_sfnode_t *pNext;
+	size_t count = 0;
+	size_t matched = 0;
+	size_t removed = 0;
+	size_t n;
+
+	key = k_spin_lock(&pKQueue->lock);
+	SYS_SFLIST_FOR_EACH_NODE (&pKQueue->data_q, pNode) {
+		count += 1;
+	}
+	k_spin_unlock(&pKQueue->lock, key);
+
+	if (count == 0) {
+		return 0;
+	}
+	ppBatch = BP_TRY_TO_TAKE(count * sizeof(sys_sfnode_t *));
+	if (ppBatch == NULL) {
+		return 0;
+	}
+
+	/* Nodes that were queued after the count aren't scanned */
+	key = k_spin_lock(&pKQueue->lock);
+	n = 0;
+	SYS_SFLIST_FOR_EACH_NODE (&pKQueue->data_q, pNode) {
+		if (n == count) {
+			break;
+		}
+		ppBatch[n++] = pNode;
+	}
+	k_spin_unlock(&pKQueue->lock, key);
+	count = n;
+
+	for (n = 0; n < count; n++) {
+		if (pMatch(BufferPool_FromNode(ppBatch[n]), pContext)) {
+			ppBatch[matched++] = ppBatch[n];
+		}
+	}
+
+	if (!Discard || matched == 0) {
+		BufferPool_Free(ppBatch);
+		return matched;
+	}
+
+	/* Nodes that were received after they were copied aren't found */
+	key = k_spin_lock(&pKQueue->lock);
+	pPrev = NULL;
+	pNode = sys_sflist_peek_head(&pKQueue->data_q);
+	while (pNode != NULL && removed < matched) {
+		pNext = sys_sflist_peek_next(pNode);
+		for (n = removed; n < matched; n++) {
+			if (ppBatch[n] == pNode) {
+				break;
+			}
+		}
+		if (n < matched) {
+			ppBatch[n] = ppBatch[removed];
+			ppBatch[removed++] = pNode;
+			sys_sflist_remove(&pKQueue->data_q, pPrev, pNode);
+		} else {
+			pPrev = pNode;
+		}
+		pNode = pNext;
+	}
+	k_spin_unlock(&pKQueue->lock, key);
+
+	/* Messages are freed (and callers of Framework_Call are woken)
+	 * after the queue is unlocked. */
+	for (n = 0; n < removed; n++) {
+		DiscardMsg(BufferPool_FromNode(ppBatch[n]));
+	}
+
+	BufferPool_Free(ppBatch);
+	return removed;
+}
+#endif
+
+static bool MatchCode(const FwkMsg_t *pMsg, void *pContext)
+{
+	return pMsg->header.msgCode == *((FwkMsgCode_t *)pContext);
+}
+
+/**
+ * @brief Return a message that was taken from a queue to the buffer pool.
+ */
+static void FreeMsg(FwkMsg_t *pMsg)
+{
+#ifdef CONFIG_FWK_STATIC_PERIODIC
+	/* The timer can send the message again (it must not be accessed) */
+	if (IS_STATIC_PERIODIC(pMsg)) {
+		FwkMsgTask_t *pMsgTask = ((FwkPeriodicMsg_t *)pMsg)->pTask;
+		atomic_clear(&pMsgTask->periodicPending);
+		return;
+	}
+#endif
+	if (pMsg->header.options &
+	    (FWK_MSG_OPTION_STATIC | FWK_MSG_OPTION_INLINE)) {
+		return;
+	}
+	BufferPool_Free(pMsg);
+}
+
+/**
+ * @brief Free a message that was taken from a queue without handling it.
+ */
+static void DiscardMsg(FwkMsg_t *pMsg)
+{
+#ifdef CONFIG_FWK_COALESCE_PERIODIC
+	if (pMsg->header.options & FWK_MSG_OPTION_PERIODIC) {
+		ReleasePeriodic(pMsg);
+	}
+#endif
+	if ((pMsg->header.options & FWK_MSG_OPTION_CALL) &&
+	    CompleteCall(pMsg, DISPATCH_ERROR)) {
+		return;
+	}
+	FreeMsg(pMsg);
+}
+
+/**
+ * @brief Wake the caller of a call message.
+ *
+ * @note The message must not be accessed after the caller is woken.
+ *
+ * @retval true if the message was given back to the caller, false if the
+ * caller stopped waiting (the message must be freed).
+ */
+static bool CompleteCall(FwkMsg_t *pMsg, DispatchResult_t Result)
+{
+	struct FwkCallCompletion *pCompletion =
+		atomic_ptr_clear(&((FwkCallMsg_t *)pMsg)->pCompletion);
+
+	if (pCompletion == NULL) {
+		return false;
+	}
+	pCompletion->result = Result;
+	k_sem_give(&pCompletion->done);
+	return true;
+}
+
+/**
+ * @brief Update a message that was taken from a queue before it is handled.
+ */
+static void PrepareToDispatch(FwkMsg_t *pMsg)
+{
+#ifdef CONFIG_FWK_COALESCE_PERIODIC
+	if (pMsg->header.options & FWK_MSG_OPTION_PERIODIC) {
+		ReleasePeriodic(pMsg);
 	}
+#else
+	ARG_UNUSED(pMsg);
+#endif
+}
 
+#ifdef CONFIG_FWK_MUX
+/**
+ * @brief Each receiver (in priority order) handles up to maxBatch messages
+ * that are already queued.
+ */
+static size_t MuxServiceReady(FwkMsgMux_t *pMux)
+{
+	size_t handled = 0;
+	size_t i;
+	size_t n;
 	FwkMsg_t *pMsg;
-	size_t purged = 0;
-	while (true) {
-		pMsg = NULL;
-		k_msgq_get(msgTaskRegistry[RxId].pMsgReceiver->pQueue, &pMsg,
-			   K_NO_WAIT);
-		if (pMsg != NULL) {
-			BufferPool_Free(pMsg);
-			purged += 1;
-		} else {
-			break;
+	BaseType_t status;
+#ifdef CONFIG_FWK_INLINE_MSGS
+	FwkMsg_t inlineMsg;
+#endif
+
+	for (i = 0; i < pMux->count; i++) {
+		FwkMsgReceiver_t *pRxer = pMux->ppReceivers[i];
+		size_t limit = MAX(pRxer->maxBatch, 1);
+
+		for (n = 0; n < limit; n++) {
+			pMsg = NULL;
+			status = ReceiveFromLanes(pRxer, &pMsg, K_NO_WAIT);
+			if ((status != FWK_SUCCESS) || (pMsg == NULL)) {
+				break;
+			}
+#ifdef CONFIG_FWK_INLINE_MSGS
+			pMsg = Framework_ExpandInline(pMsg, &inlineMsg);
+#endif
+			PrepareToDispatch(pMsg);
+			Dispatch(pRxer, pMsg);
+			handled += 1;
 		}
 	}
-	return purged;
+
+	return handled;
 }
+#endif
 
-/******************************************************************************/
-/* Local Function Definitions                                                 */
-/******************************************************************************/
 /**
- * @brief Initialize buffer pool (statistics).
+ * @brief Get the handler of a receiver for a msg code.
+ *
+ * @retval NULL if the receiver doesn't handle the msg code
  */
-static int Framework_Initialize(const struct device *device)
+static FwkMsgHandler_t *FindHandler(FwkMsgReceiver_t *pRxer,
+				    FwkMsgCode_t MsgCode)
 {
-	ARG_UNUSED(device);
+#ifdef CONFIG_FWK_DISPATCH_TABLES
+	if (pRxer->pDispatchTable != NULL) {
+		if (MsgCode < NUMBER_OF_FRAMEWORK_MSG_CODES) {
+			return pRxer->pDispatchTable[MsgCode];
+		}
+		return NULL;
+	}
+#endif
+	if (pRxer->pMsgDispatcher == NULL) {
+		return NULL;
+	}
+	return pRxer->pMsgDispatcher(MsgCode);
+}
 
-	BufferPool_Initialize();
+/**
+ * @brief Call the message handler and then free the message.
+ */
+static void Dispatch(FwkMsgReceiver_t *pRxer, FwkMsg_t *pMsg)
+{
+	FwkMsgHandler_t *msgHandler = FindHandler(pRxer, pMsg->header.msgCode);
+#ifdef CONFIG_FWK_TRAFFIC_STATS
+	RecordTraffic(pMsg->header.txId, pRxer->id);
+#endif
+	if (msgHandler != NULL) {
+#ifdef CONFIG_FWK_MSG_PROFILER
+		/* The handler may change the message (for example, a reply). */
+		FwkMsgCode_t code = pMsg->header.msgCode;
+#endif
+#ifdef TIME_HANDLERS
+		uint32_t start = k_cycle_get_32();
+#endif
+#ifdef CONFIG_FWK_LATENCY_STATS
+		/* Only buffers queued to a receiver are timestamped (only the
+		 * handler time is recorded for other messages).  The stamp is
+		 * cleared so it isn't used again if the buffer is queued
+		 * directly. */
+		uint32_t queued = 0;
+		if (!(pMsg->header.options &
+		      (FWK_MSG_OPTION_STATIC | FWK_MSG_OPTION_INLINE))) {
+			queued = BufferPool_GetTimestamp(pMsg);
+		}
+		bool timestamped = (queued != 0);
+		if (timestamped) {
+			BufferPool_SetTimestamp(pMsg, 0);
+		}
+#endif
+		DispatchResult_t result = msgHandler(pRxer, pMsg);
+#ifdef TIME_HANDLERS
+		uint32_t cycles = k_cycle_get_32() - start;
+#endif
+#ifdef CONFIG_FWK_LATENCY_STATS
+		RecordLatency(pRxer->id, timestamped, start - queued, cycles);
+#endif
+#ifdef CONFIG_FWK_MSG_PROFILER
+		RecordMsgProfile(code, cycles);
+#endif
+		if (pMsg->header.options & FWK_MSG_OPTION_CALLBACK) {
+			FwkCallbackMsg_t *pCbMsg = (FwkCallbackMsg_t *)pMsg;
+			if (pCbMsg->callback != NULL) {
+				pCbMsg->callback(pCbMsg->data);
+			}
+		}
+		if ((pMsg->header.options & FWK_MSG_OPTION_CALL) &&
+		    CompleteCall(pMsg, result)) {
+			return;
+		}
+		if (result != DISPATCH_DO_NOT_FREE) {
+			FreeMsg(pMsg);
+		}
+	} else if ((pMsg->header.options & FWK_MSG_OPTION_CALL) &&
+		   CompleteCall(pMsg, DISPATCH_ERROR)) {
+		return;
+	} else {
+		Framework_UnknownMsgHandler(pRxer, pMsg);
+	}
+}
 
-	return 0;
+/**
+ * @brief Find the receivers that have a handler for a message code.
+ *
+ * @param ppReceivers array with room for CONFIG_FWK_MAX_MSG_RECEIVERS
+ *
+ * @retval number of receivers found
+ */
+static size_t FindBroadcastReceivers(FwkMsgCode_t MsgCode,
+				     FwkMsgReceiver_t **ppReceivers)
+{
+	size_t count = 0;
+
+#ifdef CONFIG_FWK_ROUTING_INDEX
+	uint32_t receivers = 0;
+	if (MsgCode < NUMBER_OF_FRAMEWORK_MSG_CODES) {
+		receivers = (uint32_t)atomic_get(&broadcastIndex[MsgCode]);
+	}
+
+	while (receivers != 0) {
+		uint32_t i = find_lsb_set(receivers) - 1;
+		receivers &= ~BIT(i);
+		ppReceivers[count++] = msgTaskRegistry[i].pMsgReceiver;
+	}
+#else
+	uint32_t i;
+	for (i = FWK_ID_APP_START; i < CONFIG_FWK_MAX_MSG_RECEIVERS; i++) {
+		FwkMsgReceiver_t *pMsgRxer = msgTaskRegistry[i].pMsgReceiver;
+
+		if (pMsgRxer != NULL) {
+			/* The handler isn't called here.  It is only used to determine
+			 * if a task should receive a broadcast message. */
+			if (FindHandler(pMsgRxer, MsgCode) != NULL) {
+				ppReceivers[count++] = pMsgRxer;
+			}
+		}
+	}
+#endif
+
+	return count;
+}
+
+#if !defined(CONFIG_FWK_SHARED_BROADCAST) || defined(CONFIG_FWK_QUEUE_FIFO) || \
+	defined(CONFIG_FWK_RECEIVER_QUOTAS)
+/**
+ * @brief Create a copy of the message and place it on the queue.
+ */
+static BaseType_t BroadcastCopyTo(FwkMsgReceiver_t *pMsgRxer, FwkMsg_t *pMsg,
+				  size_t MsgSize)
+{
+	BaseType_t result = FWK_ERROR;
+	FwkMsg_t *pNewMsg = (FwkMsg_t *)BufferPool_TakeUninit(MsgSize);
+
+	if (pNewMsg != NULL) {
+		memcpy(pNewMsg, pMsg, MsgSize);
+		pNewMsg->header.rxId = pMsgRxer->id;
+		result = QueueTo(pMsgRxer, pNewMsg, K_NO_WAIT);
+
+		if (result != FWK_SUCCESS) {
+			BufferPool_Free(pNewMsg);
+		}
+	}
+
+	return result;
+}
+#endif
+
+#ifdef CONFIG_FWK_SHARED_BROADCAST
+/**
+ * @brief Place a shared message on the queue.
+ * The receiver owns a reference to the message.
+ */
+static BaseType_t BroadcastTo(FwkMsgReceiver_t *pMsgRxer, FwkMsg_t *pMsg,
+			      size_t MsgSize)
+{
+	BaseType_t result;
+	FwkQueue_t *pQueue = SelectQueue(pMsgRxer, pMsg);
+	bool copy = false;
+
+#ifdef CONFIG_FWK_QUEUE_FIFO
+	/* A buffer can only be linked into one queue at a time. */
+	copy = (pQueue->type == FWK_QUEUE_TYPE_FIFO);
+#endif
+#ifdef CONFIG_FWK_RECEIVER_QUOTAS
+	/* A shared buffer has one owner, so it can't be charged to each
+	 * receiver.  A receiver with a quota gets a copy that is charged. */
+	copy = copy || pMsgRxer->quotaBytes != 0 || pMsgRxer->quotaCount != 0;
+#endif
+#if defined(CONFIG_FWK_QUEUE_FIFO) || defined(CONFIG_FWK_RECEIVER_QUOTAS)
+	if (copy) {
+		result = BroadcastCopyTo(pMsgRxer, pMsg, MsgSize);
+		BufferPool_Free(pMsg);
+		return result;
+	}
+#else
+	ARG_UNUSED(MsgSize);
+	ARG_UNUSED(copy);
+#endif
+
+	result = Framework_Queue(pQueue, &pMsg, K_NO_WAIT);
+	if (result != FWK_SUCCESS) {
+		BufferPool_Free(pMsg);
+	}
+
+	return result;
+}
+#else
+static BaseType_t BroadcastTo(FwkMsgReceiver_t *pMsgRxer, FwkMsg_t *pMsg,
+			      size_t MsgSize)
+{
+	return BroadcastCopyTo(pMsgRxer, pMsg, MsgSize);
+}
+#endif
+
+#ifdef CONFIG_FWK_LATENCY_STATS
+static uint32_t LatencyBucket(uint32_t cycles)
+{
+	return MIN(find_msb_set(cycles),
+		   CONFIG_FWK_LATENCY_HISTOGRAM_BUCKETS - 1);
+}
+
+/**
+ * @param Timestamped false if the queue time of the message isn't known
+ *
+ * @note The workers of a pool update the statistics of the same receiver.
+ */
+static void RecordLatency(FwkId_t RxId, bool Timestamped, uint32_t QueueCycles,
+			  uint32_t HandlerCycles)
+{
+	if (RxId >= CONFIG_FWK_MAX_MSG_RECEIVERS) {
+		return;
+	}
+
+	struct FwkLatencyStats *p = &latencyStats[RxId];
+	k_spinlock_key_t key = k_spin_lock(&latencyLock[RxId]);
+
+	p->count += 1;
+	if (Timestamped) {
+		p->maxQueueCycles = MAX(p->maxQueueCycles, QueueCycles);
+		p->queue[LatencyBucket(QueueCycles)] += 1;
+	}
+	p->maxHandlerCycles = MAX(p->maxHandlerCycles, HandlerCycles);
+	p->handler[LatencyBucket(HandlerCycles)] += 1;
+
+	k_spin_unlock(&latencyLock[RxId], key);
+}
+#endif
+
+#ifdef CONFIG_FWK_MSG_PROFILER
+/**
+ * @note Handlers for the same message code can run in more than one thread.
+ */
+static void RecordMsgProfile(FwkMsgCode_t MsgCode, uint32_t HandlerCycles)
+{
+	if (MsgCode >= NUMBER_OF_FRAMEWORK_MSG_CODES) {
+		return;
+	}
+
+	struct FwkMsgProfile *p = &msgProfile[MsgCode];
+	k_spinlock_key_t key = k_spin_lock(&msgProfileLock);
+
+	if (p->count == 0 || HandlerCycles < p->minCycles) {
+		p->minCycles = HandlerCycles;
+	}
+	p->maxCycles = MAX(p->maxCycles, HandlerCycles);
+	p->totalCycles += HandlerCycles;
+	p->count += 1;
+
+	k_spin_unlock(&msgProfileLock, key);
+}
+#endif
+
+#ifdef CONFIG_FWK_TRAFFIC_STATS
+static void RecordTraffic(FwkId_t TxId, FwkId_t RxId)
+{
+	if (TxId < CONFIG_FWK_MAX_MSG_RECEIVERS &&
+	    RxId < CONFIG_FWK_MAX_MSG_RECEIVERS) {
+		atomic_inc(&traffic[RxId][TxId]);
+	}
+}
+
+static uint32_t LeastLoadedCpu(const uint32_t *pLoad, uint32_t Cpus)
+{
+	uint32_t cpu = 0;
+	uint32_t i;
+
+	for (i = 1; i < Cpus; i++) {
+		if (pLoad[i] < pLoad[cpu]) {
+			cpu = i;
+		}
+	}
+	return cpu;
+}
+#endif
+
+#ifdef CONFIG_FWK_ROUTING_INDEX
+/**
+ * @brief Probe the dispatcher (or dispatch table) of a newly registered
+ * receiver once for each msg code so that routing can be done with a table
+ * lookup.
+ *
+ * @note Called with interrupts locked.
+ */
+static void IndexReceiver(FwkMsgReceiver_t *pRxer)
+{
+	uint32_t code;
+
+	if (pRxer->id < FWK_ID_APP_START) {
+		return;
+	}
+
+	for (code = 0; code < NUMBER_OF_FRAMEWORK_MSG_CODES; code++) {
+		if (FindHandler(pRxer, code) == NULL) {
+			continue;
+		}
+
+		atomic_set_bit(&broadcastIndex[code], pRxer->id);
+
+		/* Receivers may register in any order.
+		 * Unicast goes to the lowest id that has a handler. */
+		if (unicastIndex[code] == FWK_ID_RESERVED ||
+		    unicastIndex[code] > pRxer->id) {
+			unicastIndex[code] = pRxer->id;
+		}
+	}
+}
+#endif
+
+#ifdef CONFIG_FWK_ROUTING_INDEX
+/**
+ * @retval receiver that can be subscribed to broadcasts of the msg code
+ * or NULL
+ */
+static FwkMsgReceiver_t *SubscriptionReceiver(FwkId_t RxId,
+					      FwkMsgCode_t MsgCode)
+{
+	if (RxId < FWK_ID_APP_START || RxId >= CONFIG_FWK_MAX_MSG_RECEIVERS) {
+		return NULL;
+	}
+	if (!msgTaskRegistry[RxId].inUse ||
+	    MsgCode >= NUMBER_OF_FRAMEWORK_MSG_CODES) {
+		return NULL;
+	}
+
+	return msgTaskRegistry[RxId].pMsgReceiver;
+}
+#endif
+
+#ifdef CONFIG_FWK_COALESCE_PERIODIC
+/**
+ * @brief Allow the timer of the task that owns a periodic message to send
+ * another one and set the number of expirations missed since the previous
+ * message.
+ *
+ * @note Pending is cleared first so that an expiration that occurs while
+ * the message is handled isn't lost.  The static message of a task is
+ * reused by the timer, so pending is cleared when it is freed (FreeMsg)
+ * instead.  Expirations while it is handled are counted as missed.
+ *
+ * @note The option is cleared so that a message is only released once (a
+ * forwarded message doesn't release the timer again).
+ */
+static void ReleasePeriodic(FwkMsg_t *pMsg)
+{
+	FwkPeriodicMsg_t *pPeriodicMsg = (FwkPeriodicMsg_t *)pMsg;
+	FwkMsgTask_t *pMsgTask = pPeriodicMsg->pTask;
+
+	pMsg->header.options &= ~FWK_MSG_OPTION_PERIODIC;
+	if (!(pMsg->header.options & FWK_MSG_OPTION_STATIC)) {
+		atomic_clear(&pMsgTask->periodicPending);
+	}
+	pPeriodicMsg->missed =
+		(uint32_t)atomic_set(&pMsgTask->periodicMissed, 0);
+}
+#endif
+
+#ifdef CONFIG_FWK_BROADCAST_DEFERRED
+/**
+ * @brief Broadcast the messages in the deferred ring.
+ *
+ * @note A producer can be interrupted after it reserves a slot and before it
+ * fills it.  The thread stops at an empty slot.  The semaphore is given again
+ * when the slot is filled.
+ */
+static void BroadcastThread(void *pArg1, void *pArg2, void *pArg3)
+{
+	ARG_UNUSED(pArg1);
+	ARG_UNUSED(pArg2);
+	ARG_UNUSED(pArg3);
+
+	FwkMsg_t *pMsg;
+
+	while (true) {
+		k_sem_take(&deferredAvailable, K_FOREVER);
+
+		while (true) {
+			pMsg = atomic_ptr_clear(
+				DEFERRED_SLOT(atomic_get(&deferredTail)));
+			if (pMsg == NULL) {
+				break;
+			}
+			/* Release the slot before the (slow) broadcast. */
+			atomic_inc(&deferredTail);
+
+			if (Framework_Broadcast(pMsg,
+						BufferPool_GetSize(pMsg)) !=
+			    FWK_SUCCESS) {
+				BufferPool_Free(pMsg);
+			}
+		}
+	}
 }
+#endif
 
 /******************************************************************************/
 /* Interrupt Service Routines                                                 */
@@ -340,15 +2578,41 @@ static void PeriodicTimerCallbackIsr(struct k_timer *pArg)
 	FwkMsgTask_t *pMsgTask =
 		(FwkMsgTask_t *)CONTAINER_OF(pArg, FwkMsgTask_t, timer);
 
-	FwkMsg_t *pMsg = (FwkMsg_t *)BufferPool_Take(sizeof(FwkMsg_t));
+#ifdef CONFIG_FWK_COALESCE_PERIODIC
+	if (!atomic_cas(&pMsgTask->periodicPending, 0, 1)) {
+		atomic_inc(&pMsgTask->periodicMissed);
+		return;
+	}
+#endif
+
+#ifdef CONFIG_FWK_STATIC_PERIODIC
+	/* Pending prevents the message from being queued twice. */
+	FwkPeriodicMsg_t *pMsg = &pMsgTask->periodic.msg;
+#else
+	FwkPeriodicMsg_t *pMsg =
+		(FwkPeriodicMsg_t *)BufferPool_Take(sizeof(FwkPeriodicMsg_t));
+#endif
 	if (pMsg != NULL) {
 		pMsg->header.msgCode = FMC_PERIODIC;
 		pMsg->header.txId = pMsgTask->rxer.id;
 		pMsg->header.rxId = pMsgTask->rxer.id;
-		BaseType_t result = Framework_Send(pMsgTask->rxer.id, pMsg);
+		pMsg->header.options = PERIODIC_MSG_OPTIONS;
+#ifdef CONFIG_FWK_COALESCE_PERIODIC
+		pMsg->pTask = pMsgTask;
+#endif
+		BaseType_t result =
+			Framework_Send(pMsgTask->rxer.id, (FwkMsg_t *)pMsg);
 		if (result != FWK_SUCCESS) {
-			BufferPool_Free(pMsg);
+			FreeMsg((FwkMsg_t *)pMsg);
+			pMsg = NULL;
 		}
 		FRAMEWORK_ASSERT(result == FWK_SUCCESS);
 	}
+
+#ifdef CONFIG_FWK_COALESCE_PERIODIC
+	if (pMsg == NULL) {
+		atomic_inc(&pMsgTask->periodicMissed);
+		atomic_clear(&pMsgTask->periodicPending);
+	}
+#endif
 }
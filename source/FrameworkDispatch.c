@@ -0,0 +1,53 @@
+/**
+ * @file FrameworkDispatch.c
+ * @brief Expands the generated handler lists into dispatch tables.
+ *
+ * Copyright (c) 2022 Laird Connectivity
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/******************************************************************************/
+/* Includes                                                                   */
+/******************************************************************************/
+#include <zephyr.h>
+
+#include "Framework.h"
+#include "FrameworkDispatch.h"
+#include <framework_msgcodes.h>
+
+/******************************************************************************/
+/* Local Function Prototypes                                                  */
+/******************************************************************************/
+/* Declare each handler */
+#define FWK_HANDLER(code, handler) FwkMsgHandler_t handler;
+#define FWK_DISPATCH_TABLE(name, ...) __VA_ARGS__
+
+#include <framework_handlers.h>
+
+#undef FWK_HANDLER
+#undef FWK_DISPATCH_TABLE
+
+/******************************************************************************/
+/* Global Function Definitions                                                */
+/******************************************************************************/
+/* Define a table and a dispatcher for each list */
+#define FWK_HANDLER(code, handler) [code] = handler,
+#define FWK_DISPATCH_TABLE(name, ...)                                          \
+	FwkMsgHandler_t *const                                                 \
+		name##DispatchTable[NUMBER_OF_FRAMEWORK_MSG_CODES] = {         \
+			__VA_ARGS__                                            \
+		};                                                             \
+                                                                               \
+	FwkMsgHandler_t *name##Dispatcher(FwkMsgCode_t MsgCode)                \
+	{                                                                      \
+		if (MsgCode < NUMBER_OF_FRAMEWORK_MSG_CODES) {                 \
+			return name##DispatchTable[MsgCode];                   \
+		}                                                              \
+		return NULL;                                                   \
+	}
+
+#include <framework_handlers.h>
+
+#undef FWK_HANDLER
+#undef FWK_DISPATCH_TABLE
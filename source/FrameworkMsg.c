@@ -23,6 +23,9 @@
 /******************************************************************************/
 static void DeallocateOnError(FwkMsg_t *pMsg, BaseType_t status);
 
+static FwkMsg_t *CreateHeaderOnlyMsg(FwkMsg_t *pInline, FwkMsgCode_t Code,
+				     FwkId_t TxId);
+
 /******************************************************************************/
 /* Global Function Definitions                                                */
 /******************************************************************************/
@@ -35,6 +38,16 @@ BaseType_t FwkMsg_Send(FwkMsg_t *pMsg)
 	return result;
 }
 
+BaseType_t FwkMsg_SendUrgent(FwkMsg_t *pMsg)
+{
+	pMsg->header.options |= FWK_MSG_OPTION_URGENT;
+	BaseType_t result = Framework_Send(pMsg->header.rxId, pMsg);
+	DeallocateOnError(pMsg, result);
+	FRAMEWORK_ASSERT(result == FWK_SUCCESS);
+
+	return result;
+}
+
 BaseType_t FwkMsg_TryToSend(FwkMsg_t *pMsg)
 {
 	BaseType_t result = Framework_Send(pMsg->header.rxId, pMsg);
@@ -43,6 +56,15 @@ BaseType_t FwkMsg_TryToSend(FwkMsg_t *pMsg)
 	return result;
 }
 
+BaseType_t FwkMsg_SendTimeout(FwkMsg_t *pMsg, TickType_t Timeout)
+{
+	BaseType_t result =
+		Framework_SendTimeout(pMsg->header.rxId, pMsg, Timeout);
+	DeallocateOnError(pMsg, result);
+
+	return result;
+}
+
 BaseType_t FwkMsg_SendTo(FwkMsg_t *pMsg, FwkId_t DestId)
 {
 	pMsg->header.rxId = DestId;
@@ -65,11 +87,11 @@ BaseType_t FwkMsg_Unicast(FwkMsg_t *pMsg)
 BaseType_t FwkMsg_CreateAndSend(FwkId_t TxId, FwkId_t RxId, FwkMsgCode_t Code)
 {
 	BaseType_t result = FWK_ERROR;
-	FwkMsg_t *pMsg = (FwkMsg_t *)BufferPool_Take(sizeof(FwkMsg_t));
+	FwkMsg_t msg;
+	FwkMsg_t *pMsg = CreateHeaderOnlyMsg(&msg, Code, TxId);
 	FRAMEWORK_ASSERT(pMsg != NULL);
 
 	if (pMsg != NULL) {
-		FRAMEWORK_MSG_HEADER_INIT(pMsg, Code, TxId);
 		result = Framework_Send(RxId, pMsg);
 		DeallocateOnError(pMsg, result);
 		FRAMEWORK_ASSERT(result == FWK_SUCCESS);
@@ -81,11 +103,11 @@ BaseType_t FwkMsg_CreateAndSend(FwkId_t TxId, FwkId_t RxId, FwkMsgCode_t Code)
 BaseType_t FwkMsg_CreateAndSendToSelf(FwkId_t Id, FwkMsgCode_t Code)
 {
 	BaseType_t result = FWK_ERROR;
-	FwkMsg_t *pMsg = (FwkMsg_t *)BufferPool_Take(sizeof(FwkMsg_t));
+	FwkMsg_t msg;
+	FwkMsg_t *pMsg = CreateHeaderOnlyMsg(&msg, Code, Id);
 	FRAMEWORK_ASSERT(pMsg != NULL);
 
 	if (pMsg != NULL) {
-		FRAMEWORK_MSG_HEADER_INIT(pMsg, Code, Id);
 		pMsg->header.rxId = Id;
 		result = Framework_Send(Id, pMsg);
 		DeallocateOnError(pMsg, result);
@@ -98,11 +120,11 @@ BaseType_t FwkMsg_CreateAndSendToSelf(FwkId_t Id, FwkMsgCode_t Code)
 BaseType_t FwkMsg_UnicastCreateAndSend(FwkId_t TxId, FwkMsgCode_t Code)
 {
 	BaseType_t result = FWK_ERROR;
-	FwkMsg_t *pMsg = (FwkMsg_t *)BufferPool_Take(sizeof(FwkMsg_t));
+	FwkMsg_t msg;
+	FwkMsg_t *pMsg = CreateHeaderOnlyMsg(&msg, Code, TxId);
 	FRAMEWORK_ASSERT(pMsg != NULL);
 
 	if (pMsg != NULL) {
-		FRAMEWORK_MSG_HEADER_INIT(pMsg, Code, TxId);
 		result = Framework_Unicast(pMsg);
 		DeallocateOnError(pMsg, result);
 		FRAMEWORK_ASSERT(result == FWK_SUCCESS);
@@ -115,10 +137,10 @@ BaseType_t FwkMsg_CreateAndBroadcast(FwkId_t TxId, FwkMsgCode_t Code)
 {
 	BaseType_t result = FWK_ERROR;
 	size_t size = sizeof(FwkMsg_t);
-	FwkMsg_t *pMsg = BufferPool_Take(size);
+	FwkMsg_t msg;
+	FwkMsg_t *pMsg = CreateHeaderOnlyMsg(&msg, Code, TxId);
 
 	if (pMsg != NULL) {
-		FRAMEWORK_MSG_HEADER_INIT(pMsg, Code, TxId);
 		pMsg->header.rxId = FWK_ID_RESERVED;
 		result = Framework_Broadcast(pMsg, size);
 		DeallocateOnError(pMsg, result);
@@ -130,6 +152,23 @@ BaseType_t FwkMsg_CreateAndBroadcast(FwkId_t TxId, FwkMsgCode_t Code)
 BaseType_t FwkMsg_Reply(FwkMsg_t *pMsg, FwkMsgCode_t Code)
 {
 	BaseType_t result = FWK_ERROR;
+
+#ifdef CONFIG_FWK_SHARED_BROADCAST
+	/* Other receivers may not have handled a shared broadcast yet.
+	 * Static and inline messages aren't from the buffer pool. */
+	if (!(pMsg->header.options &
+	      (FWK_MSG_OPTION_STATIC | FWK_MSG_OPTION_INLINE)) &&
+	    BufferPool_IsShared(pMsg)) {
+		FwkMsg_t *pCopy = BufferPool_CopyOnWrite(pMsg);
+		if (pCopy == NULL) {
+			BufferPool_Free(pMsg);
+			FRAMEWORK_ASSERT(FORCED);
+			return result;
+		}
+		pMsg = pCopy;
+	}
+#endif
+
 	FwkId_t swap = pMsg->header.rxId;
 	pMsg->header.rxId = pMsg->header.txId;
 	pMsg->header.txId = swap;
@@ -201,7 +240,30 @@ BaseType_t FwkMsg_FilteredTargettedSend(FwkMsg_t *pMsg, FwkId_t *TargetID,
 /******************************************************************************/
 static void DeallocateOnError(FwkMsg_t *pMsg, BaseType_t status)
 {
-	if (status != FWK_SUCCESS) {
+	if (status != FWK_SUCCESS &&
+	    !(pMsg->header.options & FWK_MSG_OPTION_INLINE)) {
 		BufferPool_Free(pMsg);
 	}
 }
+
+/**
+ * @brief Header-only messages are sent by value when inline messages are
+ * enabled.  Otherwise, they are allocated from the buffer pool.
+ */
+static FwkMsg_t *CreateHeaderOnlyMsg(FwkMsg_t *pInline, FwkMsgCode_t Code,
+				     FwkId_t TxId)
+{
+	FwkMsg_t *pMsg = pInline;
+
+#ifdef CONFIG_FWK_INLINE_MSGS
+	FRAMEWORK_MSG_HEADER_INIT(pMsg, Code, TxId);
+	pMsg->header.options = FWK_MSG_OPTION_INLINE;
+#else
+	pMsg = (FwkMsg_t *)BufferPool_Take(sizeof(FwkMsg_t));
+	if (pMsg != NULL) {
+		FRAMEWORK_MSG_HEADER_INIT(pMsg, Code, TxId);
+	}
+#endif
+
+	return pMsg;
+}
@@ -0,0 +1,215 @@
+/**
+ * @file FrameworkShell.c
+ * @brief
+ *
+ * Copyright (c) 2022 Laird Connectivity
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/******************************************************************************/
+/* Includes                                                                   */
+/******************************************************************************/
+#include <zephyr.h>
+#include <shell/shell.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Framework.h"
+
+/******************************************************************************/
+/* Local Function Prototypes                                                  */
+/******************************************************************************/
+#ifdef CONFIG_FWK_LATENCY_STATS
+static int fwk_latency(const struct shell *shell, size_t argc, char **argv);
+#endif
+
+#ifdef CONFIG_FWK_MSG_PROFILER
+static int fwk_profile(const struct shell *shell, size_t argc, char **argv);
+#endif
+
+#ifdef CONFIG_FWK_TRAFFIC_STATS
+static int fwk_traffic(const struct shell *shell, size_t argc, char **argv);
+#endif
+
+#ifdef CONFIG_FWK_RECEIVER_QUOTAS
+static int fwk_quota(const struct shell *shell, size_t argc, char **argv);
+#endif
+
+/******************************************************************************/
+/* Global Function Definitions                                                */
+/******************************************************************************/
+SHELL_STATIC_SUBCMD_SET_CREATE(
+	sub_fwk,
+#ifdef CONFIG_FWK_LATENCY_STATS
+	SHELL_CMD_ARG(latency, NULL,
+		      "Print latency histograms of a receiver <id> [reset]",
+		      fwk_latency, 2, 1),
+#endif
+#ifdef CONFIG_FWK_MSG_PROFILER
+	SHELL_CMD_ARG(profile, NULL,
+		      "Print handler time of each message code [reset]",
+		      fwk_profile, 1, 1),
+#endif
+#ifdef CONFIG_FWK_TRAFFIC_STATS
+	SHELL_CMD_ARG(traffic, NULL,
+		      "Print messages handled between receivers and suggest "
+		      "a CPU for each receiver <cpus> [reset]",
+		      fwk_traffic, 1, 2),
+#endif
+#ifdef CONFIG_FWK_RECEIVER_QUOTAS
+	SHELL_CMD(quota, NULL,
+		  "Print the buffers charged to each receiver and the messages "
+		  "rejected or dropped because of a quota",
+		  fwk_quota),
+#endif
+	SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(fwk, &sub_fwk, "Message Framework", NULL);
+
+/******************************************************************************/
+/* Local Function Definitions                                                 */
+/******************************************************************************/
+#ifdef CONFIG_FWK_LATENCY_STATS
+static int fwk_latency(const struct shell *shell, size_t argc, char **argv)
+{
+	FwkId_t id = (FwkId_t)strtoul(argv[1], NULL, 0);
+	const struct FwkLatencyStats *stats = Framework_GetLatencyStats(id);
+	size_t i;
+
+	if (stats == NULL) {
+		shell_error(shell, "Receiver not found");
+		return -EINVAL;
+	}
+
+	if (argc > 2 && strcmp(argv[2], "reset") == 0) {
+		Framework_ResetLatencyStats(id);
+		return 0;
+	}
+
+	shell_print(shell, "Receiver %u", id);
+	shell_print(shell, "messages              %u", stats->count);
+	shell_print(shell, "max queue time (us)   %u",
+		    k_cyc_to_us_floor32(stats->maxQueueCycles));
+	shell_print(shell, "max handler time (us) %u",
+		    k_cyc_to_us_floor32(stats->maxHandlerCycles));
+	shell_print(shell, "cycles (less than)    queue      handler");
+	for (i = 0; i < CONFIG_FWK_LATENCY_HISTOGRAM_BUCKETS; i++) {
+		if (stats->queue[i] == 0 && stats->handler[i] == 0) {
+			continue;
+		}
+		if (i < CONFIG_FWK_LATENCY_HISTOGRAM_BUCKETS - 1) {
+			shell_print(shell, "%-21u %-10u %u", (uint32_t)BIT(i),
+				    stats->queue[i], stats->handler[i]);
+		} else {
+			shell_print(shell, "%-21s %-10u %u", "max",
+				    stats->queue[i], stats->handler[i]);
+		}
+	}
+
+	return 0;
+}
+#endif
+
+#ifdef CONFIG_FWK_MSG_PROFILER
+static int fwk_profile(const struct shell *shell, size_t argc, char **argv)
+{
+	struct FwkMsgProfile profile;
+	uint32_t code;
+
+	if (argc > 1 && strcmp(argv[1], "reset") == 0) {
+		Framework_ResetMsgProfile();
+		return 0;
+	}
+
+	shell_print(shell, "code  count      min (us)   max (us)   avg (us)");
+	for (code = 0; code <= UINT8_MAX; code++) {
+		if (Framework_GetMsgProfile(code, &profile) != FWK_SUCCESS) {
+			break;
+		}
+		if (profile.count == 0) {
+			continue;
+		}
+		shell_print(shell, "%-5u %-10u %-10u %-10u %u", code,
+			    profile.count,
+			    k_cyc_to_us_floor32(profile.minCycles),
+			    k_cyc_to_us_floor32(profile.maxCycles),
+			    k_cyc_to_us_floor32(
+				    (uint32_t)(profile.totalCycles /
+					       profile.count)));
+	}
+
+	return 0;
+}
+#endif
+
+#ifdef CONFIG_FWK_TRAFFIC_STATS
+static int fwk_traffic(const struct shell *shell, size_t argc, char **argv)
+{
+	uint8_t cpu[CONFIG_FWK_MAX_MSG_RECEIVERS];
+	unsigned long cpus = CONFIG_MP_NUM_CPUS;
+	char *pEnd;
+	FwkId_t tx;
+	FwkId_t rx;
+	uint32_t count;
+
+	if (argc > 1 && strcmp(argv[argc - 1], "reset") == 0) {
+		Framework_ResetTraffic();
+		return 0;
+	}
+	if (argc > 1) {
+		cpus = strtoul(argv[1], &pEnd, 0);
+		if (*pEnd != '\0' || cpus == 0 || cpus > CONFIG_MP_NUM_CPUS) {
+			shell_error(shell, "Number of CPUs must be 1 to %u",
+				    CONFIG_MP_NUM_CPUS);
+			return -EINVAL;
+		}
+	}
+
+	shell_print(shell, "tx    rx    messages");
+	for (tx = 0; tx < CONFIG_FWK_MAX_MSG_RECEIVERS; tx++) {
+		for (rx = 0; rx < CONFIG_FWK_MAX_MSG_RECEIVERS; rx++) {
+			count = Framework_GetTraffic(tx, rx);
+			if (count != 0) {
+				shell_print(shell, "%-5u %-5u %u", tx, rx,
+					    count);
+			}
+		}
+	}
+
+	if (Framework_SuggestPlacement(cpu, (uint32_t)cpus) != FWK_SUCCESS) {
+		return -EINVAL;
+	}
+	shell_print(shell, "id    cpu");
+	for (rx = 0; rx < CONFIG_FWK_MAX_MSG_RECEIVERS; rx++) {
+		shell_print(shell, "%-5u %u", rx, cpu[rx]);
+	}
+
+	return 0;
+}
+#endif
+
+#ifdef CONFIG_FWK_RECEIVER_QUOTAS
+static int fwk_quota(const struct shell *shell, size_t argc, char **argv)
+{
+	ARG_UNUSED(argc);
+	ARG_UNUSED(argv);
+	struct FwkQuotaUsage usage;
+	FwkId_t rx;
+
+	shell_print(shell, "id    bytes      count      rejected   dropped");
+	for (rx = 0; rx < CONFIG_FWK_MAX_MSG_RECEIVERS; rx++) {
+		if (Framework_GetQuotaUsage(rx, &usage) != FWK_SUCCESS) {
+			break;
+		}
+		if (usage.count == 0 && usage.rejected == 0 &&
+		    usage.dropped == 0) {
+			continue;
+		}
+		shell_print(shell, "%-5u %-10u %-10u %-10u %u", rx, usage.bytes,
+			    usage.count, usage.rejected, usage.dropped);
+	}
+
+	return 0;
+}
+#endif
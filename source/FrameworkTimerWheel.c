@@ -0,0 +1,271 @@
+/**
+ * @file FrameworkTimerWheel.c
+ * @brief Delayed message delivery.  Pending messages are kept in a two
+ * level timer wheel that is advanced by a single kernel timer.
+ *
+ * Level 0 has a slot for each of the next 64 ticks.  Level 1 has a slot for
+ * each of the next 64 blocks of 64 ticks.  When a block starts, its level 1
+ * slot is moved into level 0.  Longer delays stay in level 1 for another
+ * rotation.
+ *
+ * Copyright (c) 2022 Laird Connectivity
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#define FWK_FNAME "FrameworkTimerWheel"
+
+/******************************************************************************/
+/* Includes                                                                   */
+/******************************************************************************/
+#include <init.h>
+#include <sys/dlist.h>
+
+#include "BufferPool.h"
+#include "Framework.h"
+
+/******************************************************************************/
+/* Local Constant, Macro and Type Definitions                                 */
+/******************************************************************************/
+#define WHEEL_BITS 6
+#define WHEEL_SLOTS BIT(WHEEL_BITS)
+#define WHEEL_MASK (WHEEL_SLOTS - 1)
+#define WHEEL_SPAN (WHEEL_SLOTS * WHEEL_SLOTS)
+
+#define TICK_PERIOD K_MSEC(CONFIG_FWK_DELAYED_SEND_TICK_MS)
+
+#define HANDLE_INDEX(h) ((h)&0xFFFF)
+#define HANDLE_GENERATION(h) ((h) >> 16)
+
+BUILD_ASSERT(CONFIG_FWK_DELAYED_SEND_ENTRIES <= 0xFFFF,
+	     "Handle has a 16-bit index");
+
+typedef struct DelayedEntry {
+	sys_dnode_t node;
+	FwkMsg_t *pMsg;
+	uint32_t expiry; /* Wheel tick */
+	uint16_t generation; /* Part of handle (never 0) */
+	FwkId_t rxId;
+	bool inUse;
+} DelayedEntry_t;
+
+/******************************************************************************/
+/* Local Function Prototypes                                                  */
+/******************************************************************************/
+static int TimerWheelInitialize(const struct device *device);
+
+static void WheelInsert(DelayedEntry_t *pEntry);
+
+static void WheelTimerCallbackIsr(struct k_timer *pArg);
+
+/******************************************************************************/
+/* Local Data Definitions                                                     */
+/******************************************************************************/
+static DelayedEntry_t entries[CONFIG_FWK_DELAYED_SEND_ENTRIES];
+static sys_dlist_t freeEntries;
+static sys_dlist_t level0[WHEEL_SLOTS];
+static sys_dlist_t level1[WHEEL_SLOTS];
+
+/* Current wheel tick and number of entries in the wheel */
+static uint32_t now;
+static uint32_t pending;
+
+static struct k_spinlock wheelLock;
+
+static K_TIMER_DEFINE(wheelTimer, WheelTimerCallbackIsr, NULL);
+
+/******************************************************************************/
+/* Global Function Definitions                                                */
+/******************************************************************************/
+SYS_INIT(TimerWheelInitialize, POST_KERNEL, 0);
+
+BaseType_t Framework_SendDelayed(FwkId_t RxId, FwkMsg_t *pMsg,
+				 TickType_t Delay, FwkDelayHandle_t *pHandle)
+{
+	FRAMEWORK_ASSERT(pMsg != NULL);
+	if (pMsg == NULL || RxId >= CONFIG_FWK_MAX_MSG_RECEIVERS) {
+		return FWK_ERROR;
+	}
+	if (K_TIMEOUT_EQ(Delay, K_FOREVER)) {
+		return FWK_ERROR;
+	}
+
+	/* The message is freed when it can't be sent (or is cancelled) */
+	if (pMsg->header.options &
+	    (FWK_MSG_OPTION_STATIC | FWK_MSG_OPTION_INLINE)) {
+		FRAMEWORK_ASSERT(false);
+		return FWK_ERROR;
+	}
+
+	/* An absolute timeout (K_TIMEOUT_ABS_*) is converted to a delay.
+	 * One that has passed is sent on the next tick. */
+	int64_t remaining = (int64_t)(sys_clock_timeout_end_calc(Delay) -
+				      (uint64_t)sys_clock_tick_get());
+	uint64_t ms = k_ticks_to_ms_ceil64((uint64_t)MAX(remaining, 0));
+	if (ms > (uint64_t)INT32_MAX * CONFIG_FWK_DELAYED_SEND_TICK_MS) {
+		return FWK_ERROR;
+	}
+
+	uint32_t ticks =
+		(uint32_t)DIV_ROUND_UP(ms, CONFIG_FWK_DELAYED_SEND_TICK_MS);
+	k_spinlock_key_t key = k_spin_lock(&wheelLock);
+
+	sys_dnode_t *pNode = sys_dlist_get(&freeEntries);
+	if (pNode == NULL) {
+		k_spin_unlock(&wheelLock, key);
+		return FWK_ERROR;
+	}
+
+	DelayedEntry_t *pEntry = CONTAINER_OF(pNode, DelayedEntry_t, node);
+	pEntry->pMsg = pMsg;
+	pEntry->rxId = RxId;
+	pEntry->inUse = true;
+	pEntry->generation += 1;
+	if (pEntry->generation == 0) {
+		pEntry->generation = 1;
+	}
+
+	/* The current tick has partly elapsed when the timer is running.
+	 * Messages are never sent early. */
+	if (pending == 0) {
+		k_timer_start(&wheelTimer, TICK_PERIOD, TICK_PERIOD);
+		ticks = MAX(ticks, 1);
+	} else {
+		ticks += 1;
+	}
+	pending += 1;
+	pEntry->expiry = now + ticks;
+	WheelInsert(pEntry);
+
+	if (pHandle != NULL) {
+		*pHandle = ((uint32_t)pEntry->generation << 16) |
+			   (uint32_t)(pEntry - entries);
+	}
+
+	k_spin_unlock(&wheelLock, key);
+	return FWK_SUCCESS;
+}
+
+BaseType_t Framework_CancelDelayed(FwkDelayHandle_t Handle)
+{
+	uint32_t index = HANDLE_INDEX(Handle);
+	if (index >= CONFIG_FWK_DELAYED_SEND_ENTRIES) {
+		return FWK_ERROR;
+	}
+
+	DelayedEntry_t *pEntry = &entries[index];
+	FwkMsg_t *pMsg = NULL;
+	k_spinlock_key_t key = k_spin_lock(&wheelLock);
+
+	if (pEntry->inUse && pEntry->generation == HANDLE_GENERATION(Handle)) {
+		sys_dlist_remove(&pEntry->node);
+		pMsg = pEntry->pMsg;
+		pEntry->inUse = false;
+		sys_dlist_append(&freeEntries, &pEntry->node);
+		pending -= 1;
+		if (pending == 0) {
+			k_timer_stop(&wheelTimer);
+		}
+	}
+
+	k_spin_unlock(&wheelLock, key);
+
+	if (pMsg == NULL) {
+		return FWK_ERROR;
+	}
+	BufferPool_Free(pMsg);
+	return FWK_SUCCESS;
+}
+
+/******************************************************************************/
+/* Local Function Definitions                                                 */
+/******************************************************************************/
+static int TimerWheelInitialize(const struct device *device)
+{
+	ARG_UNUSED(device);
+	size_t i;
+
+	sys_dlist_init(&freeEntries);
+	for (i = 0; i < WHEEL_SLOTS; i++) {
+		sys_dlist_init(&level0[i]);
+		sys_dlist_init(&level1[i]);
+	}
+	for (i = 0; i < CONFIG_FWK_DELAYED_SEND_ENTRIES; i++) {
+		sys_dnode_init(&entries[i].node);
+		sys_dlist_append(&freeEntries, &entries[i].node);
+	}
+
+	return 0;
+}
+
+/**
+ * @note Called with the wheel locked.
+ */
+static void WheelInsert(DelayedEntry_t *pEntry)
+{
+	uint32_t delta = pEntry->expiry - now;
+
+	if (delta < WHEEL_SLOTS) {
+		sys_dlist_append(&level0[pEntry->expiry & WHEEL_MASK],
+				 &pEntry->node);
+	} else if (delta < WHEEL_SPAN) {
+		sys_dlist_append(
+			&level1[(pEntry->expiry >> WHEEL_BITS) & WHEEL_MASK],
+			&pEntry->node);
+	} else {
+		/* The slot of the current block is visited after a rotation. */
+		sys_dlist_append(&level1[(now >> WHEEL_BITS) & WHEEL_MASK],
+				 &pEntry->node);
+	}
+}
+
+/******************************************************************************/
+/* Interrupt Service Routines                                                 */
+/******************************************************************************/
+static void WheelTimerCallbackIsr(struct k_timer *pArg)
+{
+	sys_dlist_t expired;
+	sys_dnode_t *pNode;
+	DelayedEntry_t *pEntry;
+	k_spinlock_key_t key = k_spin_lock(&wheelLock);
+
+	now += 1;
+
+	/* Move the level 1 slot of a new block into level 0 */
+	if ((now & WHEEL_MASK) == 0) {
+		sys_dlist_t *pSlot = &level1[(now >> WHEEL_BITS) & WHEEL_MASK];
+		sys_dlist_t cascade;
+
+		sys_dlist_init(&cascade);
+		while ((pNode = sys_dlist_get(pSlot)) != NULL) {
+			sys_dlist_append(&cascade, pNode);
+		}
+		while ((pNode = sys_dlist_get(&cascade)) != NULL) {
+			WheelInsert(CONTAINER_OF(pNode, DelayedEntry_t, node));
+		}
+	}
+
+	/* Handles of expired entries are no longer valid.  The entries are
+	 * freed after their messages are sent. */
+	sys_dlist_init(&expired);
+	while ((pNode = sys_dlist_get(&level0[now & WHEEL_MASK])) != NULL) {
+		CONTAINER_OF(pNode, DelayedEntry_t, node)->inUse = false;
+		sys_dlist_append(&expired, pNode);
+		pending -= 1;
+	}
+	if (pending == 0) {
+		k_timer_stop(pArg);
+	}
+
+	k_spin_unlock(&wheelLock, key);
+
+	while ((pNode = sys_dlist_get(&expired)) != NULL) {
+		pEntry = CONTAINER_OF(pNode, DelayedEntry_t, node);
+		if (Framework_Send(pEntry->rxId, pEntry->pMsg) != FWK_SUCCESS) {
+			BufferPool_Free(pEntry->pMsg);
+		}
+
+		key = k_spin_lock(&wheelLock);
+		sys_dlist_append(&freeEntries, pNode);
+		k_spin_unlock(&wheelLock, key);
+	}
+}